@@ -0,0 +1,163 @@
+#include "attainment_surface.hpp"
+// STL
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+//
+#include "thread_pool.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+// Sweep along the given axis k and append all faces with normal k.
+// The staircase is a map from the first to the second remaining coordinate
+// with increasing keys and strictly decreasing values.
+void sweep(span<const glm::vec3> points,
+           const glm::vec3& reference,
+           int k,
+           const cancellation_token* token,
+           attainment_surface& surface) {
+  const int a = (k + 1) % 3;
+  const int b = (k + 2) % 3;
+
+  vector<size_t> order{};
+  order.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    const auto& p = points[i];
+    if (p.x > reference.x || p.y > reference.y || p.z > reference.z) continue;
+    order.push_back(i);
+  }
+  sort(begin(order), end(order), [&](size_t i, size_t j) {
+    const auto& p = points[i];
+    const auto& q = points[j];
+    if (p[k] != q[k]) return p[k] < q[k];
+    if (p[a] != q[a]) return p[a] < q[a];
+    return p[b] < q[b];
+  });
+
+  // Add the rectangle [x0, x1] x [y0, y1] at height h as two triangles.
+  const auto emit = [&](float x0, float x1, float y0, float y1, float h) {
+    if (!(x0 < x1) || !(y0 < y1)) return;
+    if (surface.vertices.size() > numeric_limits<uint32_t>::max() - 4)
+      throw overflow_error(
+          "Attainment surface exceeds the range of 32-bit indices.");
+    const auto offset = static_cast<uint32_t>(surface.vertices.size());
+    for (auto [x, y] : {pair{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}}) {
+      glm::vec3 v;
+      v[k] = h;
+      v[a] = x;
+      v[b] = y;
+      surface.vertices.push_back(v);
+    }
+    surface.triangles.push_back({offset, offset + 1, offset + 2});
+    surface.triangles.push_back({offset, offset + 2, offset + 3});
+    // Every face with normal in the first axis direction lies on the
+    // boundary exactly once. So its volume contribution can be summed.
+    if (k == 0)
+      surface.hypervolume +=
+          double(x1 - x0) * double(y1 - y0) * double(reference[k] - h);
+  };
+
+  map<float, float> staircase{};
+  size_t count = 0;
+  for (auto i : order) {
+    if (token && (++count & 0xfff) == 0) token->check();
+    const auto u = points[i][a];
+    const auto v = points[i][b];
+    const auto h = points[i][k];
+
+    auto it = staircase.upper_bound(u);
+    auto first = it;
+    float top = reference[b];
+    if (it != begin(staircase)) {
+      const auto prev = std::prev(it);
+      // The point is dominated by the current staircase
+      // and does not generate any face.
+      if (prev->second <= v) continue;
+      top = prev->second;
+      if (prev->first == u) first = prev;
+    }
+
+    // Walk along the steps which will be dominated by the new point.
+    float x0 = u;
+    for (; it != end(staircase) && it->second > v; ++it) {
+      emit(x0, it->first, v, top, h);
+      x0 = it->first;
+      top = it->second;
+    }
+    emit(x0, (it == end(staircase)) ? reference[a] : it->first, v, top, h);
+    // Weakly dominated steps have to be removed as well.
+    if (it != end(staircase) && it->second == v) ++it;
+
+    staircase.erase(first, it);
+    staircase.emplace(u, v);
+  }
+}
+
+// Concatenate the faces of the finished sweeps in the order of their axes.
+attainment_surface merge(const array<attainment_surface, 3>& parts,
+                         const array<bool, 3>& finished) {
+  attainment_surface surface{};
+  for (int k = 0; k < 3; ++k) {
+    surface.axis_offsets[k] = surface.triangles.size();
+    if (!finished[k]) continue;
+    const auto& part = parts[k];
+    if (surface.vertices.size() + part.vertices.size() >
+        numeric_limits<uint32_t>::max())
+      throw overflow_error(
+          "Attainment surface exceeds the range of 32-bit indices.");
+    const auto offset = static_cast<uint32_t>(surface.vertices.size());
+    surface.vertices.insert(end(surface.vertices), begin(part.vertices),
+                            end(part.vertices));
+    for (auto t : part.triangles)
+      surface.triangles.push_back({t[0] + offset, t[1] + offset,
+                                   t[2] + offset});
+    surface.hypervolume += part.hypervolume;
+  }
+  surface.axis_offsets[3] = surface.triangles.size();
+  return surface;
+}
+
+attainment_surface compute(span<const glm::vec3> points,
+                           const glm::vec3& reference,
+                           const cancellation_token* token,
+                           const function<void(attainment_surface)>* publish) {
+  array<attainment_surface, 3> parts{};
+  array<bool, 3> finished{};
+  mutex finished_mutex{};
+  task_group group{};
+  for (int k = 0; k < 3; ++k)
+    group.run([&, k] {
+      sweep(points, reference, k, token, parts[k]);
+      scoped_lock lock{finished_mutex};
+      finished[k] = true;
+      if (publish && count(begin(finished), end(finished), true) < 3)
+        (*publish)(merge(parts, finished));
+    });
+  group.wait();
+  return merge(parts, finished);
+}
+
+}  // namespace
+
+attainment_surface compute_attainment_surface(span<const glm::vec3> points,
+                                              const glm::vec3& reference) {
+  return compute(points, reference, nullptr, nullptr);
+}
+
+attainment_surface compute_attainment_surface(
+    span<const glm::vec3> points,
+    const glm::vec3& reference,
+    const cancellation_token& token,
+    const function<void(attainment_surface)>& publish) {
+  return compute(points, reference, &token, &publish);
+}
+
+}  // namespace vipo
@@ -0,0 +1,49 @@
+#pragma once
+// STL
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "background_job.hpp"
+
+namespace vipo {
+
+// The attainment surface of a Pareto frontier is the boundary
+// of the region dominated by the frontier and bounded by a reference point.
+// For minimization problems, this is the union of all boxes [p, reference].
+// Its faces are axis-aligned rectangles and grouped by their normal axis
+// such that every group can be drawn with its own shade.
+struct attainment_surface {
+  std::vector<glm::vec3> vertices{};
+  std::vector<std::array<uint32_t, 3>> triangles{};
+  // Triangles of faces with normal axis k are given by the index range
+  // [axis_offsets[k], axis_offsets[k + 1]).
+  std::array<size_t, 4> axis_offsets{};
+  // Volume of the dominated region which is the hypervolume indicator.
+  double hypervolume = 0;
+};
+
+// Construct the attainment surface by three plane sweeps, one for every axis.
+// Each sweep maintains the two-dimensional staircase of non-dominated points
+// seen so far and emits only the rectangles that are newly dominated.
+// Therefore, the runtime is O(n log n + k) for n points and k output faces.
+// Points not dominating the reference point are ignored.
+// The sweeps are independent and run in parallel.
+// Throws 'std::overflow_error' if 32-bit indices are not sufficient.
+attainment_surface compute_attainment_surface(
+    std::span<const glm::vec3> points, const glm::vec3& reference);
+
+// Compute the attainment surface as a background job. The faces of
+// finished sweeps are published while the remaining ones are running.
+// Throws 'vipo::job_cancelled' soon after the job has been cancelled.
+attainment_surface compute_attainment_surface(
+    std::span<const glm::vec3> points,
+    const glm::vec3& reference,
+    const cancellation_token& token,
+    const std::function<void(attainment_surface)>& publish);
+
+}  // namespace vipo
@@ -0,0 +1,82 @@
+#include "axis_scaling.hpp"
+// STL
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+// Scalar transformation of a single objective value.
+// Has to be kept consistent with the vertex shader.
+inline double scale_value(axis_scale scale, double x, double threshold) {
+  switch (scale) {
+    case axis_scale::logarithmic:
+      return log(max(x, 1e-300));
+    case axis_scale::symlog:
+      return copysign(log1p(abs(x) / threshold), x);
+    default:
+      return x;
+  }
+}
+
+}  // namespace
+
+const char* name(axis_scale scale) noexcept {
+  switch (scale) {
+    case axis_scale::logarithmic:
+      return "log";
+    case axis_scale::symlog:
+      return "symlog";
+    default:
+      return "linear";
+  }
+}
+
+axis_scaling make_axis_scaling(const objective_bounds& bounds,
+                               const objective_transform& storage,
+                               const array<axis_scale, 3>& scales) {
+  axis_scaling scaling{};
+  scaling.scales = scales;
+  const auto normalized = fit_objective_transform(bounds);
+  scaling.offset =
+      glm::vec3((normalized.center - storage.center) * storage.scale);
+  scaling.factor = glm::vec3(normalized.scale / storage.scale);
+  scaling.center = glm::vec3(storage.center);
+  scaling.radius = glm::vec3(1.0 / storage.scale);
+  for (int k = 0; k < 3; ++k) {
+    const auto magnitude = max(abs(bounds.min[k]), abs(bounds.max[k]));
+    const auto threshold = (magnitude > 0) ? 1e-3 * magnitude : 1.0;
+    scaling.threshold[k] = threshold;
+    // Without positive values, the logarithm is not meaningful.
+    // The axis is then collapsed onto a single value.
+    const auto lower = (scales[k] == axis_scale::logarithmic)
+                           ? min(bounds.min_positive[k], bounds.max[k])
+                           : bounds.min[k];
+    scaling.scaled_min[k] = scale_value(scales[k], lower, threshold);
+    scaling.scaled_max[k] = scale_value(scales[k], bounds.max[k], threshold);
+  }
+  return scaling;
+}
+
+glm::vec3 axis_scaling::apply(const glm::vec3& v) const noexcept {
+  glm::vec3 result;
+  for (int k = 0; k < 3; ++k) {
+    if (scales[k] == axis_scale::linear) {
+      result[k] = (v[k] - offset[k]) * factor[k];
+      continue;
+    }
+    const auto x = center[k] + radius[k] * v[k];
+    const auto y = scale_value(scales[k], x, threshold[k]);
+    const auto extent = scaled_max[k] - scaled_min[k];
+    result[k] = (extent > 0)
+                    ? float(clamp(2.0 * (y - scaled_min[k]) / extent - 1.0,
+                                  -1.0, 1.0))
+                    : 0.0f;
+  }
+  return result;
+}
+
+}  // namespace vipo
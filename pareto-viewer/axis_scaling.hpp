@@ -0,0 +1,48 @@
+#pragma once
+// STL
+#include <array>
+//
+#include <glm/glm.hpp>
+//
+#include "objective_space.hpp"
+
+namespace vipo {
+
+enum class axis_scale : int { linear = 0, logarithmic = 1, symlog = 2 };
+
+// Return the name of the given scale for the user interface.
+const char* name(axis_scale scale) noexcept;
+
+// Per-axis nonlinear scaling of the objectives which is applied
+// in the vertex shader. The members are uploaded as uniforms.
+// So changing the scale of an axis does not touch the vertex buffers.
+// Vertices are given in storage space. Linear axes are mapped onto
+// [-1, 1] by '(v - offset) * factor' to not lose precision.
+// For nonlinear axes, the objective 'center + radius * v' is transformed
+// and mapped from the transformed bounds [scaled_min, scaled_max]
+// back onto [-1, 1].
+struct axis_scaling {
+  std::array<axis_scale, 3> scales{};
+  glm::vec3 offset{0.0f};
+  glm::vec3 factor{1.0f};
+  glm::vec3 center{0.0f};
+  glm::vec3 radius{1.0f};
+  // Symmetric logarithm is linear inside [-threshold, threshold].
+  glm::vec3 threshold{1.0f};
+  glm::vec3 scaled_min{-1.0f};
+  glm::vec3 scaled_max{1.0f};
+
+  // CPU version of the vertex shader transformation
+  // needed for picking and other screen-space queries.
+  glm::vec3 apply(const glm::vec3& v) const noexcept;
+};
+
+// Construct the scaling from the bounds of the objectives
+// and the transform that maps objectives to stored vertices.
+// The transformed bounds follow from the monotony of every scale.
+// So no additional pass over the data is needed.
+axis_scaling make_axis_scaling(const objective_bounds& bounds,
+                               const objective_transform& storage,
+                               const std::array<axis_scale, 3>& scales);
+
+}  // namespace vipo
@@ -0,0 +1,141 @@
+#pragma once
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+//
+#include "thread_pool.hpp"
+
+namespace vipo {
+
+// Thrown by 'cancellation_token::check' to unwind a cancelled job.
+struct job_cancelled : std::exception {
+  const char* what() const noexcept override { return "Job was cancelled."; }
+};
+
+// Flag shared between a background job and its owner.
+// Jobs have to check it regularly to not waste cores on stale work.
+class cancellation_token {
+ public:
+  cancellation_token() : flag_{std::make_shared<std::atomic<bool>>(false)} {}
+
+  bool cancelled() const noexcept {
+    return flag_->load(std::memory_order_relaxed);
+  }
+  void check() const {
+    if (cancelled()) throw job_cancelled{};
+  }
+  void cancel() const noexcept {
+    flag_->store(true, std::memory_order_relaxed);
+  }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+enum class job_status { none, partial, complete };
+
+// Computation on the shared thread pool with background priority whose
+// results are polled by the render loop without ever blocking it.
+// Partial results can be published while the job is running.
+// Only the latest result is kept. Older ones are simply replaced.
+template <typename result>
+class background_job {
+ public:
+  using publisher = std::function<void(result)>;
+  using work =
+      std::function<result(const cancellation_token&, const publisher&)>;
+
+  background_job() = default;
+  ~background_job() { cancel(); }
+  background_job(const background_job&) = delete;
+  background_job& operator=(const background_job&) = delete;
+
+  // Cancel the current job and start the given one. Results of the
+  // cancelled job are discarded. Waits for the cancelled job to stop
+  // because it may still read data that is about to change.
+  void restart(work w) {
+    cancel();
+    cancellation_token token{};
+    {
+      std::scoped_lock lock{mutex_};
+      token_ = token;
+      running_ = true;
+      status_ = job_status::none;
+      error_ = nullptr;
+    }
+    thread_pool::shared().submit(
+        [this, w = std::move(w), token] {
+          const publisher publish = [this, &token](result r) {
+            deliver(token, std::move(r), job_status::partial);
+          };
+          try {
+            token.check();
+            deliver(token, w(token, publish), job_status::complete);
+          } catch (const job_cancelled&) {
+          } catch (...) {
+            std::scoped_lock lock{mutex_};
+            if (!token.cancelled()) error_ = std::current_exception();
+          }
+          // The owner may be destroyed as soon as the lock is released.
+          std::scoped_lock lock{mutex_};
+          running_ = false;
+          stopped_.notify_all();
+        },
+        task_priority::background);
+  }
+
+  // Cancel the current job and wait for it to stop.
+  void cancel() {
+    std::unique_lock lock{mutex_};
+    token_.cancel();
+    stopped_.wait(lock, [this] { return !running_; });
+    status_ = job_status::none;
+  }
+
+  // Wait for the current job to stop without cancelling it.
+  void wait() {
+    std::unique_lock lock{mutex_};
+    stopped_.wait(lock, [this] { return !running_; });
+  }
+
+  bool running() const {
+    std::scoped_lock lock{mutex_};
+    return running_;
+  }
+
+  // Move the latest result into 'r' if there is a new one.
+  // The complete result is the last one of a job.
+  // Rethrows the exception of a failed job.
+  job_status poll(result& r) {
+    std::scoped_lock lock{mutex_};
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    if (status_ == job_status::none) return job_status::none;
+    r = std::move(latest_);
+    return std::exchange(status_, job_status::none);
+  }
+
+ private:
+  void deliver(const cancellation_token& token,
+               result&& r,
+               job_status status) {
+    std::scoped_lock lock{mutex_};
+    if (token.cancelled()) return;
+    latest_ = std::move(r);
+    status_ = status;
+  }
+
+  mutable std::mutex mutex_{};
+  std::condition_variable stopped_{};
+  cancellation_token token_{};
+  bool running_ = false;
+  job_status status_ = job_status::none;
+  result latest_{};
+  std::exception_ptr error_{};
+};
+
+}  // namespace vipo
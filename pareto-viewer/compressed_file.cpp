@@ -0,0 +1,411 @@
+#include "compressed_file.hpp"
+// STL
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+//
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+//
+#include <zlib.h>
+#include <zstd.h>
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+bool ends_with(const string& path, const string& suffix) {
+  return path.size() >= suffix.size() &&
+         path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Frames with more decompressed data than this number of blocks
+// are not decompressed as a whole but streamed.
+constexpr size_t max_frame_blocks = 4;
+
+}  // namespace
+
+compression compression_of(const string& path) {
+  if (ends_with(path, ".gz")) return compression::gzip;
+  if (ends_with(path, ".zst")) return compression::zstd;
+  return compression::none;
+}
+
+string strip_compression(const string& path) {
+  switch (compression_of(path)) {
+    case compression::gzip:
+      return path.substr(0, path.size() - 3);
+    case compression::zstd:
+      return path.substr(0, path.size() - 4);
+    default:
+      return path;
+  }
+}
+
+decompressing_stream::decompressing_stream(const string& path,
+                                           size_t block_size)
+    : file_{make_unique<mapped_file>(path)},
+      block_size_{block_size},
+      max_ahead_{max<size_t>(2, thread::hardware_concurrency() + 2)} {
+  file_->advise_sequential();
+  const auto type = compression_of(path);
+  if (type != compression::zstd) {
+    if (type == compression::none)
+      throw runtime_error("Failed to decompress file '" + path +
+                          "'. Its compression is unknown.");
+    start(type);
+    return;
+  }
+
+  // Independent frames can be decompressed in parallel
+  // if their decompressed size is known and small enough.
+  vector<span<const char>> frames{};
+  bool independent = true;
+  for (size_t offset = 0; offset < file_->size();) {
+    const auto frame = file_->data() + offset;
+    const auto size =
+        ZSTD_findFrameCompressedSize(frame, file_->size() - offset);
+    if (ZSTD_isError(size))
+      throw runtime_error("Failed to decompress file '" + path + "'. " +
+                          ZSTD_getErrorName(size));
+    const auto content = ZSTD_getFrameContentSize(frame, size);
+    if (content == ZSTD_CONTENTSIZE_UNKNOWN ||
+        content == ZSTD_CONTENTSIZE_ERROR ||
+        content > max_frame_blocks * block_size_)
+      independent = false;
+    frames.push_back({frame, size});
+    offset += size;
+  }
+  if (!independent || frames.size() < 2) {
+    start(type);
+    return;
+  }
+  block_count_ = frames.size();
+  const auto thread_count =
+      clamp<size_t>(thread::hardware_concurrency(), 1, frames.size());
+  auto next_frame = make_shared<atomic<size_t>>(0);
+  for (size_t i = 0; i < thread_count; ++i)
+    threads_.emplace_back([this, frames, next_frame] {
+      try {
+        decompress_zstd_frames(frames, *next_frame);
+      } catch (...) {
+        fail(current_exception());
+      }
+    });
+}
+
+decompressing_stream::decompressing_stream(int descriptor, size_t block_size)
+    : descriptor_{descriptor},
+      input_(size_t{1} << 20),
+      block_size_{block_size},
+      max_ahead_{max<size_t>(2, thread::hardware_concurrency() + 2)} {
+  if (pipe2(wakeup_, O_CLOEXEC) != 0)
+    throw runtime_error(string("Failed to create pipe. ") + strerror(errno));
+  threads_.emplace_back([this] {
+    try {
+      read_descriptor();
+    } catch (...) {
+      fail(current_exception());
+    }
+  });
+}
+
+void decompressing_stream::start(compression type) {
+  threads_.emplace_back([this, type] {
+    try {
+      if (type == compression::gzip)
+        decompress_gzip();
+      else if (type == compression::zstd)
+        decompress_zstd_stream();
+      else
+        copy_input();
+    } catch (...) {
+      fail(current_exception());
+    }
+  });
+}
+
+decompressing_stream::~decompressing_stream() {
+  {
+    scoped_lock lock{mutex_};
+    stop_ = true;
+  }
+  consumed_.notify_all();
+  // A reader blocked on an idle pipe or terminal would never return.
+  if (wakeup_[1] != -1) {
+    const char byte = 0;
+    while (::write(wakeup_[1], &byte, 1) < 0 && errno == EINTR) continue;
+  }
+  for (auto& t : threads_) t.join();
+  for (auto fd : wakeup_)
+    if (fd != -1) ::close(fd);
+}
+
+span<const char> decompressing_stream::next() {
+  unique_lock lock{mutex_};
+  // Nothing has been handed out in front of the first call.
+  if (current_.capacity() != 0) free_.push_back(move(current_));
+  current_ = {};
+  // Skippable frames result in empty blocks which are not handed out.
+  while (current_.empty()) {
+    produced_.wait(lock, [this] {
+      return error_ || next_ == block_count_ || ready_.contains(next_);
+    });
+    if (error_) rethrow_exception(error_);
+    if (next_ == block_count_) return {};
+    const auto it = ready_.find(next_);
+    current_ = move(it->second);
+    ready_.erase(it);
+    ++next_;
+    consumed_.notify_all();
+  }
+  return current_;
+}
+
+vector<char> decompressing_stream::acquire() {
+  vector<char> block{};
+  {
+    scoped_lock lock{mutex_};
+    if (!free_.empty()) {
+      block = move(free_.back());
+      free_.pop_back();
+    }
+  }
+  resize_block(block, block_size_);
+  return block;
+}
+
+void decompressing_stream::resize_block(vector<char>& block, size_t size) {
+  const auto capacity = block.capacity();
+  block.resize(size);
+  if (block.capacity() == capacity) return;
+  scoped_lock lock{mutex_};
+  block_memory_.add(block.capacity() - capacity);
+}
+
+bool decompressing_stream::deliver(size_t index, vector<char>&& block) {
+  unique_lock lock{mutex_};
+  consumed_.wait(lock,
+                 [&] { return stop_ || index < next_ + max_ahead_; });
+  if (stop_) return false;
+  ready_.emplace(index, move(block));
+  produced_.notify_all();
+  return true;
+}
+
+void decompressing_stream::finish(size_t block_count) {
+  scoped_lock lock{mutex_};
+  block_count_ = block_count;
+  produced_.notify_all();
+}
+
+void decompressing_stream::fail(exception_ptr error) {
+  {
+    scoped_lock lock{mutex_};
+    if (!error_) error_ = error;
+    // Other producers do not need to continue.
+    stop_ = true;
+  }
+  produced_.notify_all();
+  consumed_.notify_all();
+}
+
+span<const char> decompressing_stream::read_input() {
+  if (!peeked_.empty()) return exchange(peeked_, {});
+  if (file_) {
+    // The input size of zlib is limited to 32 bits.
+    const auto size =
+        min<size_t>(file_->size() - input_offset_, size_t{1} << 30);
+    const span<const char> piece{file_->data() + input_offset_, size};
+    input_offset_ += size;
+    return piece;
+  }
+  return {input_.data(), read_some(input_.data(), input_.size())};
+}
+
+size_t decompressing_stream::read_some(char* data, size_t size) {
+  while (true) {
+    // Wait until the descriptor or the wake-up pipe becomes readable.
+    pollfd fds[] = {{descriptor_, POLLIN, 0}, {wakeup_[0], POLLIN, 0}};
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      throw runtime_error(string("Failed to read input. ") + strerror(errno));
+    }
+    // Producers notice the stop when they deliver their next block.
+    if (fds[1].revents != 0) return 0;
+    const auto n = ::read(descriptor_, data, size);
+    if (n >= 0) return size_t(n);
+    if (errno != EINTR && errno != EAGAIN)
+      throw runtime_error(string("Failed to read input. ") + strerror(errno));
+  }
+}
+
+void decompressing_stream::read_descriptor() {
+  // Pipes may return less data than requested.
+  // So read until the magic bytes are complete.
+  size_t size = 0;
+  while (size < 4) {
+    const auto n = read_some(input_.data() + size, input_.size() - size);
+    if (n == 0) break;
+    size += n;
+  }
+  const auto data = reinterpret_cast<const unsigned char*>(input_.data());
+  peeked_ = {input_.data(), size};
+  if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b)
+    decompress_gzip();
+  else if (size >= 4 && data[0] == 0x28 && data[1] == 0xb5 &&
+           data[2] == 0x2f && data[3] == 0xfd)
+    decompress_zstd_stream();
+  else
+    copy_input();
+}
+
+void decompressing_stream::copy_input() {
+  size_t index = 0;
+  auto block = acquire();
+  size_t used = 0;
+  for (auto piece = read_input(); !piece.empty(); piece = read_input()) {
+    while (!piece.empty()) {
+      const auto size = min(piece.size(), block.size() - used);
+      memcpy(block.data() + used, piece.data(), size);
+      used += size;
+      piece = piece.subspan(size);
+      if (used < block.size()) continue;
+      if (!deliver(index++, move(block))) return;
+      block = acquire();
+      used = 0;
+    }
+  }
+  block.resize(used);
+  if (used != 0 && !deliver(index++, move(block))) return;
+  finish(index);
+}
+
+void decompressing_stream::decompress_gzip() {
+  z_stream stream{};
+  // Detect the gzip or zlib header automatically.
+  if (inflateInit2(&stream, 15 + 32) != Z_OK)
+    throw runtime_error("Failed to initialize gzip decompression.");
+  struct guard {
+    z_stream& stream;
+    ~guard() { inflateEnd(&stream); }
+  } g{stream};
+
+  bool exhausted = false;
+  const auto refill = [&] {
+    const auto piece = read_input();
+    exhausted = piece.empty();
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(piece.data()));
+    stream.avail_in = uInt(piece.size());
+  };
+  size_t index = 0;
+  auto block = acquire();
+  size_t used = 0;
+  while (true) {
+    if (stream.avail_in == 0 && !exhausted) refill();
+    stream.next_out = reinterpret_cast<Bytef*>(block.data() + used);
+    stream.avail_out = uInt(block.size() - used);
+    const auto result = inflate(&stream, Z_NO_FLUSH);
+    used = block.size() - stream.avail_out;
+    if (result == Z_STREAM_END) {
+      if (stream.avail_in == 0 && !exhausted) refill();
+      if (stream.avail_in == 0) break;
+      // Concatenated gzip members form a single stream.
+      inflateReset(&stream);
+    } else if (result == Z_BUF_ERROR && stream.avail_in == 0 && exhausted) {
+      throw runtime_error("Failed to decompress gzip data. It is truncated.");
+    } else if (result != Z_OK && result != Z_BUF_ERROR) {
+      throw runtime_error(string("Failed to decompress gzip data. ") +
+                          (stream.msg ? stream.msg : "It is corrupt."));
+    }
+    if (used == block.size()) {
+      if (!deliver(index++, move(block))) return;
+      block = acquire();
+      used = 0;
+    }
+  }
+  block.resize(used);
+  if (used != 0 && !deliver(index++, move(block))) return;
+  finish(index);
+}
+
+void decompressing_stream::decompress_zstd_stream() {
+  const auto context = ZSTD_createDStream();
+  if (!context)
+    throw runtime_error("Failed to initialize Zstandard decompression.");
+  struct guard {
+    ZSTD_DStream* context;
+    ~guard() { ZSTD_freeDStream(context); }
+  } g{context};
+
+  // Concatenated frames are decoded one after another by the same context.
+  ZSTD_inBuffer input{nullptr, 0, 0};
+  size_t index = 0;
+  auto block = acquire();
+  size_t used = 0;
+  size_t result = 0;
+  while (true) {
+    // A partially filled block means that all input has been flushed.
+    if (input.pos == input.size && used != block.size()) {
+      const auto piece = read_input();
+      if (piece.empty()) break;
+      input = {piece.data(), piece.size(), 0};
+    }
+    if (used == block.size()) {
+      if (!deliver(index++, move(block))) return;
+      block = acquire();
+      used = 0;
+      // The last frame may end exactly at the end of the block.
+      if (input.pos == input.size && result == 0) continue;
+    }
+    ZSTD_outBuffer output{block.data(), block.size(), used};
+    result = ZSTD_decompressStream(context, &output, &input);
+    if (ZSTD_isError(result))
+      throw runtime_error(string("Failed to decompress Zstandard data. ") +
+                          ZSTD_getErrorName(result));
+    used = output.pos;
+  }
+  if (result != 0)
+    throw runtime_error(
+        "Failed to decompress Zstandard data. It is truncated.");
+  block.resize(used);
+  if (used != 0 && !deliver(index++, move(block))) return;
+  finish(index);
+}
+
+void decompressing_stream::decompress_zstd_frames(
+    const vector<span<const char>>& frames,
+    atomic<size_t>& next_frame) {
+  const auto context = ZSTD_createDCtx();
+  if (!context)
+    throw runtime_error("Failed to initialize Zstandard decompression.");
+  struct guard {
+    ZSTD_DCtx* context;
+    ~guard() { ZSTD_freeDCtx(context); }
+  } g{context};
+
+  // Frames are claimed in increasing order. So the next frame to be
+  // handed out is always being decompressed by one of the threads.
+  for (auto i = next_frame++; i < frames.size(); i = next_frame++) {
+    const auto& frame = frames[i];
+    auto block = acquire();
+    resize_block(block,
+                 ZSTD_getFrameContentSize(frame.data(), frame.size()));
+    const auto size = ZSTD_decompressDCtx(context, block.data(), block.size(),
+                                          frame.data(), frame.size());
+    if (ZSTD_isError(size))
+      throw runtime_error(string("Failed to decompress Zstandard data. ") +
+                          ZSTD_getErrorName(size));
+    block.resize(size);
+    if (!deliver(i, move(block))) return;
+  }
+}
+
+}  // namespace vipo
@@ -0,0 +1,113 @@
+#pragma once
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include "mapped_file.hpp"
+#include "memory_stats.hpp"
+
+namespace vipo {
+
+enum class compression { none, gzip, zstd };
+
+// Detect the compression of a file by its extension '.gz' or '.zst'.
+compression compression_of(const std::string& path);
+
+// Return the path without the extension of its compression.
+std::string strip_compression(const std::string& path);
+
+// Decompress a memory-mapped file on background threads and hand out
+// the decompressed data in consecutive blocks. While the caller parses
+// one block, the following blocks are already decompressed. Zstandard
+// files consisting of several frames, as written by 'pzstd' or by
+// concatenating compressed files, are decompressed in parallel
+// with one frame per thread. Gzip data and single frames
+// can only be decompressed sequentially on one background thread.
+// The decompressed data is never stored as a whole.
+class decompressing_stream {
+ public:
+  static constexpr size_t default_block_size = size_t{1} << 24;
+
+  // Throws 'std::runtime_error' if the file cannot be opened.
+  explicit decompressing_stream(const std::string& path,
+                                size_t block_size = default_block_size);
+
+  // Read from a file descriptor like a pipe or the standard input
+  // which cannot seek and whose size is unknown. The compression is
+  // detected by the magic bytes of the data. Uncompressed data is read
+  // in pieces and copied into the blocks on a background thread. Destroying the
+  // stream interrupts a pending read. The descriptor is not closed.
+  explicit decompressing_stream(int descriptor,
+                                size_t block_size = default_block_size);
+  ~decompressing_stream();
+  decompressing_stream(const decompressing_stream&) = delete;
+  decompressing_stream& operator=(const decompressing_stream&) = delete;
+
+  // Wait for the next block of decompressed data. The block stays valid
+  // until the next call. An empty block marks the end of the data.
+  // Errors of the background threads are rethrown.
+  std::span<const char> next();
+
+ private:
+  void start(compression type);
+  void read_descriptor();
+  void copy_input();
+  void decompress_gzip();
+  void decompress_zstd_stream();
+  void decompress_zstd_frames(const std::vector<std::span<const char>>& frames,
+                              std::atomic<size_t>& next_frame);
+
+  // Buffers are recycled to avoid repeated allocations of whole blocks.
+  std::vector<char> acquire();
+  // Resize a block and account the capacity allocated for it.
+  void resize_block(std::vector<char>& block, size_t size);
+  // Hand out the block with the given index in order. Waits while the
+  // producers are too far ahead. Returns false if the stream is stopped.
+  bool deliver(size_t index, std::vector<char>&& block);
+  void finish(size_t block_count);
+  void fail(std::exception_ptr error);
+
+  // Return the next piece of compressed input or an empty span at its end.
+  // Mapped files are handed out at once. Descriptors are read in pieces.
+  std::span<const char> read_input();
+
+  // Read at most 'size' bytes from the descriptor. Returns zero at the end
+  // of the input or when the stream is stopped.
+  size_t read_some(char* data, size_t size);
+
+  std::unique_ptr<mapped_file> file_{};
+  int descriptor_ = -1;
+  // Pipe whose read end becomes readable when the stream is destroyed.
+  // It interrupts a reader that waits for input from the descriptor.
+  int wakeup_[2] = {-1, -1};
+  size_t input_offset_ = 0;
+  std::vector<char> input_{};
+  // Input that has already been read to detect the compression.
+  std::span<const char> peeked_{};
+  size_t block_size_;
+  size_t max_ahead_;
+
+  std::mutex mutex_{};
+  std::condition_variable produced_{};
+  std::condition_variable consumed_{};
+  std::map<size_t, std::vector<char>> ready_{};
+  std::vector<std::vector<char>> free_{};
+  memory_account block_memory_{memory_pool::parse_buffers};
+  std::vector<char> current_{};
+  size_t next_ = 0;
+  size_t block_count_ = -1;
+  std::exception_ptr error_{};
+  bool stop_ = false;
+  std::vector<std::thread> threads_{};
+};
+
+}  // namespace vipo
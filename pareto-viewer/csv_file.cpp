@@ -0,0 +1,243 @@
+#include "csv_file.hpp"
+// STL
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <memory_resource>
+#include <stdexcept>
+#include <string_view>
+//
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+//
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "parse_arena.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+// Skip 'count' delimiters in the current line and return the position
+// after the last one. If the line ends before, the position of the
+// newline or the end of data is returned.
+const char* skip_fields(const char* p,
+                        const char* end,
+                        char delimiter,
+                        size_t count) {
+  if (count == 0) return p;
+#if defined(__SSE2__)
+  const auto d = _mm_set1_epi8(delimiter);
+  const auto n = _mm_set1_epi8('\n');
+  for (; p + 16 <= end; p += 16) {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto delimiters =
+        uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(block, d)));
+    const auto newlines =
+        uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(block, n)));
+    // Only delimiters in front of the first newline are part of the line.
+    if (newlines) delimiters &= (newlines & -newlines) - 1;
+    const auto found = size_t(__builtin_popcount(delimiters));
+    if (found >= count) {
+      for (; count > 1; --count) delimiters &= delimiters - 1;
+      return p + __builtin_ctz(delimiters) + 1;
+    }
+    if (newlines) return p + __builtin_ctz(newlines);
+    count -= found;
+  }
+#endif
+  for (; p != end; ++p) {
+    if (*p == '\n') return p;
+    if (*p == delimiter && --count == 0) return p + 1;
+  }
+  return p;
+}
+
+// Return the end of the current field.
+inline const char* field_end(const char* p, const char* end, char delimiter) {
+  while (p != end && *p != delimiter && *p != '\n') ++p;
+  return p;
+}
+
+// Return the beginning of the next line.
+inline const char* next_line(const char* p, const char* end) {
+  const auto n = static_cast<const char*>(memchr(p, '\n', end - p));
+  return n ? n + 1 : end;
+}
+
+// Convert a field to a number. Surrounding whitespace,
+// a carriage return, and quotes are allowed.
+double parse_field(const char* first, const char* last, size_t offset) {
+  while (first != last && (*first == ' ' || *first == '"')) ++first;
+  while (last != first &&
+         (last[-1] == ' ' || last[-1] == '\r' || last[-1] == '"'))
+    --last;
+  double value;
+  const auto [ptr, error] = from_chars(first, last, value);
+  if (error != errc{} || ptr != last || first == last)
+    throw runtime_error("Failed to parse CSV field '" +
+                        string(first, last - first) + "' at byte offset " +
+                        to_string(offset) + ".");
+  return value;
+}
+
+// Split the header line into column names.
+vector<string> split_header(string_view line, char delimiter) {
+  vector<string> names{};
+  while (true) {
+    const auto last = min(line.find(delimiter), line.size());
+    auto name = line.substr(0, last);
+    while (!name.empty() && (name.front() == ' ' || name.front() == '"'))
+      name.remove_prefix(1);
+    while (!name.empty() &&
+           (name.back() == ' ' || name.back() == '"' || name.back() == '\r'))
+      name.remove_suffix(1);
+    names.emplace_back(name);
+    if (last == line.size()) break;
+    line.remove_prefix(last + 1);
+  }
+  return names;
+}
+
+// Resolve a column given by name or zero-based index.
+size_t resolve_column(const string& column, const vector<string>& names) {
+  const auto it = find(begin(names), end(names), column);
+  if (it != end(names)) return it - begin(names);
+  size_t index;
+  const auto [ptr, error] =
+      from_chars(column.data(), column.data() + column.size(), index);
+  if (error == errc{} && ptr == column.data() + column.size()) return index;
+  throw runtime_error("Failed to find CSV column '" + column + "'.");
+}
+
+}  // namespace
+
+void load_csv(const string& path,
+              const csv_options& options,
+              const vector<string>& selection,
+              large_vector<glm::dvec3>& objectives) {
+  mapped_file file{path};
+  if (file.size() == 0)
+    throw runtime_error("Failed to load file '" + path + "'. It is empty.");
+  file.advise_sequential();
+  const char* data = file.data();
+  const char* data_end = data + file.size();
+
+  char delimiter = options.delimiter;
+  if (!delimiter)
+    delimiter = (path.size() >= 4 && path.substr(path.size() - 4) == ".tsv")
+                    ? '\t'
+                    : ',';
+
+  // Resolve the selected columns by the header line.
+  const char* first = data;
+  vector<string> names{};
+  if (options.header) {
+    first = next_line(data, data_end);
+    names = split_header(string_view(data, first - data - (first[-1] == '\n')),
+                         delimiter);
+  }
+  array<size_t, 3> columns{0, 1, 2};
+  if (!selection.empty()) {
+    if (selection.size() != 3)
+      throw runtime_error("Exactly three CSV columns have to be selected.");
+    for (int k = 0; k < 3; ++k)
+      columns[k] = resolve_column(selection[k], names);
+  }
+  // Fields are visited in increasing column order.
+  array<int, 3> order{0, 1, 2};
+  sort(begin(order), end(order),
+       [&](int i, int j) { return columns[i] < columns[j]; });
+
+  // Split the data into chunks at line boundaries.
+  const size_t size = data_end - first;
+  const auto chunk_count = parallel_chunk_count(size, size_t{1} << 20);
+  vector<const char*> bounds(chunk_count + 1, data_end);
+  bounds[0] = first;
+  for (size_t i = 1; i < chunk_count; ++i)
+    bounds[i] = next_line(max(first + i * size / chunk_count, bounds[i - 1]),
+                          data_end);
+
+  // Guess the number of lines to reduce reallocations.
+  const auto expected_rows = [&](size_t chunk) {
+    return size_t(bounds[chunk + 1] - bounds[chunk]) / 32;
+  };
+  // Objectives of a chunk grow in an arena sized for the expected rows.
+  deque<parse_arena> arenas{};
+  vector<pmr::vector<glm::dvec3>> chunks{};
+  chunks.reserve(chunk_count);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    arenas.emplace_back(expected_rows(i) * sizeof(glm::dvec3));
+    chunks.emplace_back(arenas[i].resource());
+  }
+  vector<string> errors(chunk_count);
+  const auto parse_chunk = [&](size_t chunk) {
+    auto& result = chunks[chunk];
+    result.reserve(expected_rows(chunk));
+    try {
+      for (auto p = bounds[chunk]; p < bounds[chunk + 1];) {
+        if (*p == '\n' || *p == '\r' || *p == '#') {
+          p = next_line(p, data_end);
+          continue;
+        }
+        glm::dvec3 x;
+        size_t column = 0;
+        int previous = -1;
+        for (auto k : order) {
+          // The same column may be selected more than once.
+          if (previous != -1 && columns[k] == column) {
+            x[k] = x[previous];
+            continue;
+          }
+          previous = k;
+          p = skip_fields(p, data_end, delimiter, columns[k] - column);
+          column = columns[k];
+          if (p == data_end || *p == '\n')
+            throw runtime_error(
+                "Failed to find CSV column " + to_string(column) +
+                " in line at byte offset " + to_string(p - data) + ".");
+          const auto last = field_end(p, data_end, delimiter);
+          x[k] = parse_field(p, last, p - data);
+          p = last;
+        }
+        result.push_back(x);
+        p = next_line(p, data_end);
+      }
+    } catch (exception& e) {
+      errors[chunk] = e.what();
+    }
+  };
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) parse_chunk(chunk);
+      },
+      1);
+  for (const auto& error : errors)
+    if (!error.empty()) throw runtime_error(error);
+
+  // Concatenate the chunks in their original order.
+  size_t offset = objectives.size();
+  vector<size_t> offsets(chunk_count);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    offsets[i] = offset;
+    offset += chunks[i].size();
+  }
+  objectives.resize(offset);
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) {
+          copy(begin(chunks[chunk]), end(chunks[chunk]),
+               begin(objectives) + offsets[chunk]);
+        }
+      },
+      1);
+}
+
+}  // namespace vipo
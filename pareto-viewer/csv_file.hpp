@@ -0,0 +1,32 @@
+#pragma once
+// STL
+#include <string>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "large_array.hpp"
+
+namespace vipo {
+
+struct csv_options {
+  // Field delimiter. Zero means ',' or '\t' for files ending in '.tsv'.
+  char delimiter = 0;
+  // The first line names the columns.
+  bool header = true;
+};
+
+// Load three objective columns of a CSV or TSV file given by their
+// names or zero-based indices. If none are given, the first three are used.
+// The memory-mapped file is split at line boundaries into one
+// chunk per thread. Delimiters are found with SIMD instructions and
+// only the selected fields are converted to numbers. All other fields
+// are skipped by counting delimiters. Quoted fields must not contain
+// delimiters or newlines. Empty lines and lines starting with '#'
+// are ignored. Throws 'std::runtime_error' on malformed input.
+void load_csv(const std::string& path,
+              const csv_options& options,
+              const std::vector<std::string>& columns,
+              large_vector<glm::dvec3>& objectives);
+
+}  // namespace vipo
@@ -0,0 +1,75 @@
+#pragma once
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+namespace vipo {
+
+// Set of modified index ranges of an array whose copy on the GPU
+// has to be updated. Overlapping and close ranges are coalesced because
+// uploading a few unchanged elements is cheaper than another call.
+class dirty_ranges {
+ public:
+  explicit dirty_ranges(size_t merge_distance = 256) noexcept
+      : merge_distance_{merge_distance} {}
+
+  bool empty() const noexcept { return ranges_.empty(); }
+  // Number of elements that still have to be uploaded.
+  size_t size() const noexcept { return size_; }
+  size_t range_count() const noexcept { return ranges_.size(); }
+
+  void clear() noexcept {
+    ranges_.clear();
+    size_ = 0;
+  }
+
+  // Mark the elements in [first, last) as modified.
+  void mark(size_t first, size_t last) {
+    if (first >= last) return;
+    // Find all ranges that overlap or are close to the new one.
+    auto it = ranges_.upper_bound(first + merge_distance_);
+    while (it != ranges_.begin()) {
+      const auto previous = std::prev(it);
+      if (previous->second + merge_distance_ < first) break;
+      it = previous;
+    }
+    while (it != ranges_.end() && it->first <= last + merge_distance_) {
+      first = std::min(first, it->first);
+      last = std::max(last, it->second);
+      size_ -= it->second - it->first;
+      it = ranges_.erase(it);
+    }
+    ranges_.emplace(first, last);
+    size_ += last - first;
+  }
+
+  // Call f(first, last) for the leading ranges with at most 'budget'
+  // elements in total and remove them. The range exceeding the budget
+  // is split and its remainder is deferred to the next call.
+  // Returns the number of elements that were passed to f.
+  template <typename function>
+  size_t flush(size_t budget, function&& f) {
+    size_t count = 0;
+    while (!ranges_.empty() && count < budget) {
+      const auto it = ranges_.begin();
+      const auto [first, last] = *it;
+      const auto n = std::min(last - first, budget - count);
+      ranges_.erase(it);
+      if (first + n < last) ranges_.emplace(first + n, last);
+      size_ -= n;
+      count += n;
+      f(first, first + n);
+    }
+    return count;
+  }
+
+ private:
+  // Disjoint ranges [first, last) ordered by their first index.
+  std::map<size_t, size_t> ranges_{};
+  size_t size_ = 0;
+  size_t merge_distance_;
+};
+
+}  // namespace vipo
@@ -0,0 +1,257 @@
+#include "frontier_cache.hpp"
+// STL
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+//
+#include <unistd.h>
+//
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+constexpr uint64_t prime1 = 0x9e3779b185ebca87;
+constexpr uint64_t prime2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t prime3 = 0x165667b19e3779f9;
+
+inline uint64_t read_word(const char* p) noexcept {
+  uint64_t x;
+  memcpy(&x, p, sizeof(x));
+  return x;
+}
+
+inline uint64_t mix(uint64_t hash, uint64_t word) noexcept {
+  return rotl(hash + word * prime2, 31) * prime1;
+}
+
+inline uint64_t finalize(uint64_t hash) noexcept {
+  hash ^= hash >> 33;
+  hash *= prime2;
+  hash ^= hash >> 29;
+  hash *= prime3;
+  return hash ^ (hash >> 32);
+}
+
+// Hash a block with four independent lanes such that
+// the multiplications of consecutive words can overlap.
+uint64_t block_hash(const char* data, size_t size, uint64_t seed) noexcept {
+  uint64_t lanes[4] = {seed + prime1 + prime2, seed + prime2, seed,
+                       seed - prime1};
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32)
+    for (int k = 0; k < 4; ++k)
+      lanes[k] = mix(lanes[k], read_word(data + i + 8 * k));
+  uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) +
+                  rotl(lanes[2], 12) + rotl(lanes[3], 18) + size;
+  for (; i + 8 <= size; i += 8) hash = mix(hash, read_word(data + i));
+  for (; i < size; ++i) hash = mix(hash, uint8_t(data[i]));
+  return finalize(hash);
+}
+
+constexpr size_t section_alignment = 64;
+
+inline size_t align(size_t offset) noexcept {
+  return (offset + section_alignment - 1) / section_alignment *
+         section_alignment;
+}
+
+// Byte offsets of the sections and the total size of a cache file.
+array<size_t, 5> section_offsets(const frontier_cache_header& header) {
+  array<size_t, 5> offsets{};
+  offsets[0] = align(sizeof(frontier_cache_header));
+  offsets[1] =
+      align(offsets[0] + header.objective_count * sizeof(glm::dvec3));
+  offsets[2] = align(offsets[1] + header.vertex_count * sizeof(glm::vec3));
+  offsets[3] = align(offsets[2] + header.edge_count * sizeof(edge));
+  offsets[4] =
+      align(offsets[3] + header.surface_vertex_count * sizeof(glm::vec3));
+  return offsets;
+}
+
+size_t file_size(const frontier_cache_header& header) {
+  return section_offsets(header)[4] +
+         header.surface_triangle_count * sizeof(array<uint32_t, 3>);
+}
+
+}  // namespace
+
+uint64_t content_hash(const char* data, size_t size) {
+  constexpr size_t block_size = size_t{1} << 20;
+  const auto block_count = (size + block_size - 1) / block_size;
+  vector<uint64_t> hashes(block_count);
+  parallel_chunks(
+      block_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto i = first; i < last; ++i)
+          hashes[i] = block_hash(data + i * block_size,
+                                 min(block_size, size - i * block_size), i);
+      },
+      1);
+  return block_hash(reinterpret_cast<const char*>(hashes.data()),
+                    hashes.size() * sizeof(uint64_t), size);
+}
+
+uint64_t frontier_cache_key(const string& path, const load_options& options) {
+  const mapped_file file{path};
+  file.advise_sequential();
+  stringstream description{};
+  description << frontier_cache_header::current_version << '\n'
+              << path.substr(min(path.rfind('.'), path.size())) << '\n'
+              << options.csv.delimiter << options.csv.header << '\n'
+              << options.array << '\n';
+  for (const auto& column : options.columns) description << column << ',';
+  const auto text = description.str();
+  return content_hash(file.data(), file.size()) ^
+         rotl(content_hash(text.data(), text.size()), 17);
+}
+
+string default_cache_directory() {
+  if (const auto directory = getenv("VIPO_CACHE_DIR")) return directory;
+  if (const auto directory = getenv("XDG_CACHE_HOME"))
+    return string(directory) + "/vipo";
+  if (const auto home = getenv("HOME")) return string(home) + "/.cache/vipo";
+  return ".vipo-cache";
+}
+
+string frontier_cache_path(const string& directory, uint64_t key) {
+  stringstream path{};
+  path << directory << '/' << hex << setw(16) << setfill('0') << key
+       << ".cache";
+  return path.str();
+}
+
+shared_ptr<const mapped_file> read_frontier_cache(const string& path,
+                                                  uint64_t key,
+                                                  frontier_cache_entry& entry) {
+  error_code error{};
+  if (!filesystem::is_regular_file(path, error)) return {};
+  auto file = make_shared<const mapped_file>(path);
+  if (file->size() < sizeof(frontier_cache_header)) return {};
+  frontier_cache_header header;
+  memcpy(&header, file->data(), sizeof(header));
+  // Every count is bounded by the file size before the layout is computed.
+  // So the section offsets cannot overflow.
+  const auto fits = [&](uint64_t count, size_t item_size) {
+    return count <= file->size() / item_size;
+  };
+  if (memcmp(header.magic, frontier_cache_header::magic_string,
+             sizeof(header.magic)) != 0 ||
+      header.version != frontier_cache_header::current_version ||
+      header.key != key || !fits(header.objective_count, sizeof(glm::dvec3)) ||
+      !fits(header.vertex_count, sizeof(glm::vec3)) ||
+      !fits(header.edge_count, sizeof(edge)) ||
+      !fits(header.surface_vertex_count, sizeof(glm::vec3)) ||
+      !fits(header.surface_triangle_count, sizeof(array<uint32_t, 3>)) ||
+      file_size(header) != file->size())
+    return {};
+
+  const auto offsets = section_offsets(header);
+  const auto section = [&](size_t i) { return file->data() + offsets[i]; };
+  frontier_cache_entry result{};
+  result.objectives = {reinterpret_cast<const glm::dvec3*>(section(0)),
+                       header.objective_count};
+  result.vertices = {reinterpret_cast<const glm::vec3*>(section(1)),
+                     header.vertex_count};
+  result.edges = {reinterpret_cast<const edge*>(section(2)),
+                  header.edge_count};
+  result.surface_vertices = {reinterpret_cast<const glm::vec3*>(section(3)),
+                             header.surface_vertex_count};
+  result.surface_triangles = {
+      reinterpret_cast<const array<uint32_t, 3>*>(section(4)),
+      header.surface_triangle_count};
+  for (int i = 0; i < 4; ++i)
+    result.surface_axis_offsets[i] = header.surface_axis_offsets[i];
+  result.hypervolume = header.hypervolume;
+  result.transform = header.transform;
+  result.bounds = header.bounds;
+
+  // The viewer uses all indices without further checks. So a corrupt
+  // entry is treated like a stale one and the input is reloaded.
+  if (header.objective_count != 0 &&
+      header.objective_count != header.vertex_count)
+    return {};
+  if (find_invalid_edge(header.vertex_count, result.edges) !=
+      result.edges.size())
+    return {};
+  const auto& axis_offsets = result.surface_axis_offsets;
+  if (!is_sorted(begin(axis_offsets), end(axis_offsets)) ||
+      axis_offsets.back() > header.surface_triangle_count)
+    return {};
+  const auto surface_vertex_count = header.surface_vertex_count;
+  if (any_of(begin(result.surface_triangles), end(result.surface_triangles),
+             [&](const array<uint32_t, 3>& t) {
+               return max({t[0], t[1], t[2]}) >= surface_vertex_count;
+             }))
+    return {};
+  entry = result;
+  return file;
+}
+
+void write_frontier_cache(const string& path,
+                          uint64_t key,
+                          const frontier_cache_entry& entry) {
+  frontier_cache_header header{};
+  memcpy(header.magic, frontier_cache_header::magic_string,
+         sizeof(header.magic));
+  header.version = frontier_cache_header::current_version;
+  header.key = key;
+  header.objective_count = entry.objectives.size();
+  header.vertex_count = entry.vertices.size();
+  header.edge_count = entry.edges.size();
+  header.surface_vertex_count = entry.surface_vertices.size();
+  header.surface_triangle_count = entry.surface_triangles.size();
+  for (int i = 0; i < 4; ++i)
+    header.surface_axis_offsets[i] = entry.surface_axis_offsets[i];
+  header.hypervolume = entry.hypervolume;
+  header.transform = entry.transform;
+  header.bounds = entry.bounds;
+
+  const auto parent = filesystem::path(path).parent_path();
+  error_code error{};
+  if (!parent.empty()) filesystem::create_directories(parent, error);
+  // Concurrent viewers of the same input must not share temporary files.
+  const auto temporary = path + "." + to_string(getpid()) + ".tmp";
+  // A failed write must not leave the temporary file behind.
+  const auto fail = [&](const string& message) {
+    filesystem::remove(temporary, error);
+    throw runtime_error(message);
+  };
+  {
+    fstream file{temporary, ios::out | ios::binary | ios::trunc};
+    if (!file.is_open())
+      throw runtime_error("Failed to open file '" + temporary +
+                          "' for writing.");
+    const auto offsets = section_offsets(header);
+    const auto write = [&](const void* data, size_t size, size_t offset) {
+      // Pad the previous section up to the beginning of this one.
+      static constexpr char zeros[section_alignment]{};
+      file.write(zeros, offset - size_t(file.tellp()));
+      file.write(static_cast<const char*>(data), size);
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(entry.objectives.data(), entry.objectives.size_bytes(), offsets[0]);
+    write(entry.vertices.data(), entry.vertices.size_bytes(), offsets[1]);
+    write(entry.edges.data(), entry.edges.size_bytes(), offsets[2]);
+    write(entry.surface_vertices.data(), entry.surface_vertices.size_bytes(),
+          offsets[3]);
+    write(entry.surface_triangles.data(),
+          entry.surface_triangles.size_bytes(), offsets[4]);
+    if (!file.flush()) fail("Failed to write file '" + temporary + "'.");
+  }
+  filesystem::rename(temporary, path, error);
+  if (error)
+    fail("Failed to rename file '" + temporary + "' to '" + path + "'.");
+}
+
+}  // namespace vipo
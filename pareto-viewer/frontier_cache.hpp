@@ -0,0 +1,88 @@
+#pragma once
+// STL
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+//
+#include <glm/glm.hpp>
+//
+#include "frontier_file.hpp"
+#include "mapped_file.hpp"
+#include "objective_space.hpp"
+
+namespace vipo {
+
+// Frontier Cache File Layout
+// Everything that is derived from an input file and its load options
+// is stored in one file per input. The header is followed by sections
+// for objectives, render vertices, edges, and the attainment surface.
+// Every section starts at a multiple of 64 bytes. So all of them
+// can be used directly from a memory mapping of the file.
+struct frontier_cache_header {
+  static constexpr char magic_string[8] = "VIPOCCH";
+  static constexpr uint32_t current_version = 1;
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+  // Objectives are empty if the vertices are the objectives.
+  uint64_t objective_count;
+  uint64_t vertex_count;
+  uint64_t edge_count;
+  uint64_t surface_vertex_count;
+  uint64_t surface_triangle_count;
+  uint64_t surface_axis_offsets[4];
+  double hypervolume;
+  objective_transform transform;
+  objective_bounds bounds;
+};
+
+// Derived data of a frontier as stored in a cache file.
+struct frontier_cache_entry {
+  std::span<const glm::dvec3> objectives{};
+  std::span<const glm::vec3> vertices{};
+  std::span<const edge> edges{};
+  objective_transform transform{};
+  objective_bounds bounds{};
+  std::span<const glm::vec3> surface_vertices{};
+  std::span<const std::array<uint32_t, 3>> surface_triangles{};
+  std::array<size_t, 4> surface_axis_offsets{};
+  double hypervolume = 0;
+};
+
+// Fast 64-bit hash of the given data. Blocks of the data are hashed
+// in parallel and their hashes are combined in order.
+uint64_t content_hash(const char* data, size_t size);
+
+// Key of the cache entry for an input file. It depends on the content
+// of the file, its extension, and all options that change its loading.
+uint64_t frontier_cache_key(const std::string& path,
+                            const load_options& options);
+
+// The directory given by 'VIPO_CACHE_DIR' or 'vipo'
+// inside of the user's cache directory.
+std::string default_cache_directory();
+
+// Path of the cache file for the given key inside of the directory.
+std::string frontier_cache_path(const std::string& directory, uint64_t key);
+
+// Map a cache file and let the entry point into the mapping.
+// Returns an empty pointer if the file does not exist, belongs to another
+// key, or is invalid. Sizes and all indices of the sections are checked.
+// The entry is only assigned if the file is valid. Missing entries
+// are not an error.
+std::shared_ptr<const mapped_file> read_frontier_cache(
+    const std::string& path,
+    uint64_t key,
+    frontier_cache_entry& entry);
+
+// Write the entry to a temporary file and rename it afterwards such that
+// concurrent readers never see incomplete files. Missing directories
+// are created. Throws 'std::runtime_error' if the file cannot be written.
+void write_frontier_cache(const std::string& path,
+                          uint64_t key,
+                          const frontier_cache_entry& entry);
+
+}  // namespace vipo
@@ -0,0 +1,119 @@
+#include "frontier_file.hpp"
+// STL
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+//
+#include <unistd.h>
+//
+#include "compressed_file.hpp"
+#include "npy_file.hpp"
+#include "obj_file.hpp"
+#include "ply_file.hpp"
+#include "text_frontier.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+void load_text_stream(const string& path,
+                      decompressing_stream& stream,
+                      text_dialect dialect,
+                      frontier_data& frontier) {
+  parse_text_stream([&stream] { return stream.next(); }, dialect,
+                    frontier.objectives, frontier.edges);
+  if (dialect == text_dialect::obj) remove_duplicate_edges(frontier.edges);
+  check_edges(path, frontier.objectives.size(), frontier.edges);
+}
+
+}  // namespace
+
+void load_text_frontier(const string& path,
+                        large_vector<glm::dvec3>& objectives,
+                        large_vector<edge>& edges) {
+  const mapped_file file{path};
+  file.advise_sequential();
+  parse_text_lines(file.data(), file.data() + file.size(), 1,
+                   text_dialect::native, objectives, edges);
+  if (objectives.empty())
+    throw runtime_error("Failed to load file '" + path +
+                        "'. It does not contain any vertices.");
+  // Vertices may be defined after the edges referencing them.
+  // So indices can only be checked at the end.
+  check_edges(path, objectives.size(), edges);
+}
+
+void remove_duplicate_edges(large_vector<edge>& edges) {
+  for (auto& e : edges)
+    if (e.first > e.second) swap(e.first, e.second);
+  sort(begin(edges), end(edges));
+  edges.erase(unique(begin(edges), end(edges)), end(edges));
+}
+
+size_t find_invalid_edge(size_t vertex_count, span<const edge> edges) {
+  for (size_t i = 0; i < edges.size(); ++i)
+    if (max(edges[i].first, edges[i].second) >= vertex_count) return i;
+  return edges.size();
+}
+
+void check_edges(const string& path,
+                 size_t vertex_count,
+                 const large_vector<edge>& edges) {
+  const auto i = find_invalid_edge(vertex_count, edges);
+  if (i == edges.size()) return;
+  throw runtime_error("Failed to load file '" + path + "'. Edge " +
+                      to_string(i) + " references a non-existing vertex.");
+}
+
+void load_frontier(const string& path,
+                   const load_options& options,
+                   frontier_data& frontier) {
+  const auto extension = path.substr(min(path.rfind('.'), path.size()));
+  if (path == "-") {
+    // Pipes can only be read once from front to back
+    // and their size is unknown in advance.
+    decompressing_stream stream{STDIN_FILENO};
+    load_text_stream(path, stream, text_dialect::native, frontier);
+  } else if (compression_of(path) != compression::none) {
+    // Compressed text is parsed block by block while
+    // the following blocks are decompressed in the background.
+    const auto name = strip_compression(path);
+    const auto inner = name.substr(min(name.rfind('.'), name.size()));
+    if (inner == ".csv" || inner == ".tsv" || inner == ".npy" ||
+        inner == ".npz" || inner == ".ply")
+      throw runtime_error("Failed to load file '" + path +
+                          "'. Only text and OBJ frontiers can be compressed.");
+    const auto dialect =
+        (inner == ".obj") ? text_dialect::obj : text_dialect::native;
+    decompressing_stream stream{path};
+    load_text_stream(path, stream, dialect, frontier);
+  } else if (extension == ".csv" || extension == ".tsv") {
+    load_csv(path, options.csv, options.columns, frontier.objectives);
+  } else if (extension == ".npy" || extension == ".npz") {
+    auto file = make_shared<const mapped_file>(path);
+    const auto array =
+        (extension == ".npy")
+            ? parse_npy(file->data(), file->size())
+            : find_npz_array(file->data(), file->size(), options.array);
+    const auto columns = select_npy_columns(array, options.columns);
+    // Float32 arrays in C order are used without any copy.
+    frontier.mapped_vertices = view_npy_vertices(array, columns);
+    if (!frontier.mapped_vertices.empty())
+      frontier.mapping = move(file);
+    else
+      convert_npy(array, columns, frontier.objectives);
+  } else if (extension == ".ply") {
+    load_ply(path, options.columns, frontier);
+  } else if (extension == ".obj") {
+    load_obj(path, frontier.objectives, frontier.edges);
+  } else {
+    load_text_frontier(path, frontier.objectives, frontier.edges);
+  }
+  if (frontier.size() == 0)
+    throw runtime_error("Failed to load file '" + path +
+                        "'. It does not contain any vertices.");
+}
+
+}  // namespace vipo
@@ -0,0 +1,87 @@
+#pragma once
+// STL
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "csv_file.hpp"
+#include "large_array.hpp"
+#include "mapped_file.hpp"
+
+namespace vipo {
+
+// Edges reference vertices by 64-bit indices such that
+// frontiers with more than 2^32 vertices can be represented.
+using edge = std::pair<uint64_t, uint64_t>;
+
+// Parse a Pareto frontier text file consisting of lines
+// 'v <x> <y> <z>' for vertices and 'l <i> <j> ...' for edges
+// and polylines. Lines starting with '#' are comments.
+// Objective values are parsed in double precision.
+// The file is memory-mapped and parsed in parallel chunks.
+// Throws 'std::runtime_error' with the line number when an unknown command,
+// a malformed number, an index overflow, or an edge referencing
+// a non-existing vertex is encountered.
+void load_text_frontier(const std::string& path,
+                        large_vector<glm::dvec3>& objectives,
+                        large_vector<edge>& edges);
+
+// Make all edges point from the smaller to the larger index, sort them,
+// and remove the duplicates. Meshes list every inner edge twice.
+void remove_duplicate_edges(large_vector<edge>& edges);
+
+// Return the index of the first edge that references a non-existing
+// vertex or the number of edges if all of them are valid.
+size_t find_invalid_edge(size_t vertex_count, std::span<const edge> edges);
+
+// Throw 'std::runtime_error' if an edge references a non-existing vertex.
+void check_edges(const std::string& path,
+                 size_t vertex_count,
+                 const large_vector<edge>& edges);
+
+// Options for all supported input formats.
+struct load_options {
+  // Names or zero-based indices of the three objective columns
+  // for tables and arrays or names of the PLY vertex properties.
+  // If empty, the first three columns are used.
+  std::vector<std::string> columns{};
+  csv_options csv{};
+  // Name of the array inside of an .npz archive.
+  std::string array{};
+};
+
+// A loaded Pareto frontier. Objectives are given in double precision.
+// Inputs that can be used as float vertices without any conversion
+// are instead borrowed from the memory mapping of the file.
+struct frontier_data {
+  large_vector<glm::dvec3> objectives{};
+  large_vector<edge> edges{};
+  std::shared_ptr<const mapped_file> mapping{};
+  std::span<const glm::vec3> mapped_vertices{};
+
+  size_t size() const noexcept {
+    return mapped_vertices.empty() ? objectives.size()
+                                   : mapped_vertices.size();
+  }
+};
+
+// Load a Pareto frontier and choose the format by the file extension.
+// Files ending in '.csv' or '.tsv' are read as tables.
+// Files ending in '.npy' or '.npz' are read as NumPy arrays.
+// Files ending in '.ply' are read as polygon files.
+// Files ending in '.obj' are read as Wavefront OBJ files.
+// Text and OBJ files compressed by gzip or Zstandard and ending
+// in '.gz' or '.zst' are decompressed while they are parsed.
+// The path '-' reads a possibly compressed text frontier
+// from the standard input.
+// All other files are read as Pareto frontier text files.
+void load_frontier(const std::string& path,
+                   const load_options& options,
+                   frontier_data& frontier);
+
+}  // namespace vipo
@@ -0,0 +1,62 @@
+#include "large_array.hpp"
+// STL
+#include <cstdint>
+// POSIX
+#include <sys/mman.h>
+//
+#include "memory_stats.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+size_t mapped_size(size_t bytes) {
+  return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+}
+
+void* map_huge_pages(size_t size) {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+  // Explicit huge pages are only available if the administrator
+  // has reserved them. Otherwise, the mapping fails immediately.
+  void* data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+  if (data != MAP_FAILED) return data;
+#endif
+  // Transparent huge pages need mappings aligned to huge pages.
+  // So one more huge page is mapped and the unaligned ends are unmapped.
+  void* padded = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (padded == MAP_FAILED) throw bad_alloc{};
+  const auto first = reinterpret_cast<uintptr_t>(padded);
+  const auto aligned = (first + huge_page_size - 1) & ~(huge_page_size - 1);
+  if (aligned != first) munmap(padded, aligned - first);
+  if (const auto tail = first + huge_page_size - aligned; tail != 0)
+    munmap(reinterpret_cast<void*>(aligned + size), tail);
+  const auto data = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+  // Only a hint. Without transparent huge pages, normal pages are used.
+  madvise(data, size, MADV_HUGEPAGE);
+#endif
+  return data;
+}
+
+}  // namespace
+
+void* allocate_large_array(size_t bytes, size_t alignment) {
+  count_allocation();
+  if (bytes < huge_page_size)
+    return ::operator new(bytes, align_val_t{alignment});
+  return map_huge_pages(mapped_size(bytes));
+}
+
+void free_large_array(void* data, size_t bytes, size_t alignment) noexcept {
+  if (bytes < huge_page_size)
+    ::operator delete(data, align_val_t{alignment});
+  else
+    munmap(data, mapped_size(bytes));
+}
+
+}  // namespace vipo
@@ -0,0 +1,59 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vipo {
+
+// Arrays of at least this size are mapped directly and backed by huge pages.
+constexpr size_t huge_page_size = size_t{1} << 21;
+
+// Allocate memory for an array of the given size in bytes.
+// Large arrays are aligned to huge pages which are requested explicitly
+// and otherwise advised as transparent huge pages. The memory is not
+// touched. So only the pages that are written are ever faulted in.
+// Throws 'std::bad_alloc' on failure.
+void* allocate_large_array(size_t bytes, size_t alignment);
+void free_large_array(void* data, size_t bytes, size_t alignment) noexcept;
+
+// Allocator for the columns of large frontiers like objectives,
+// edges, and vertices. Trivial elements are not initialized by 'resize'
+// such that parallel passes fill them without a serial pass before.
+template <typename T>
+class large_array_allocator {
+ public:
+  using value_type = T;
+
+  large_array_allocator() noexcept = default;
+  template <typename U>
+  large_array_allocator(const large_array_allocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(allocate_large_array(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* data, size_t n) noexcept {
+    free_large_array(data, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U, typename... arguments>
+  void construct(U* p, arguments&&... args) {
+    if constexpr (sizeof...(args) == 0 &&
+                  std::is_trivially_default_constructible_v<U>)
+      ::new (static_cast<void*>(p)) U;
+    else
+      ::new (static_cast<void*>(p)) U(std::forward<arguments>(args)...);
+  }
+
+  friend bool operator==(const large_array_allocator&,
+                         const large_array_allocator&) noexcept {
+    return true;
+  }
+};
+
+template <typename T>
+using large_vector = std::vector<T, large_array_allocator<T>>;
+
+}  // namespace vipo
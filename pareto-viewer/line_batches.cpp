@@ -0,0 +1,237 @@
+#include "line_batches.hpp"
+// STL
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+using namespace std;
+using namespace gl;
+
+namespace vipo {
+
+buffer_limits query_buffer_limits() {
+  constexpr GLint lower_bound = 1 << 16;
+  GLint max_vertices = 0;
+  GLint max_indices = 0;
+  glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, &max_vertices);
+  glGetIntegerv(GL_MAX_ELEMENTS_INDICES, &max_indices);
+  buffer_limits limits{};
+  limits.max_vertices = max(max_vertices, lower_bound);
+  limits.max_indices = max(max_indices, lower_bound);
+  return limits;
+}
+
+void line_batches::upload(span<const glm::vec3> vertices,
+                          vector<edge>& edges,
+                          GLint vpos_location,
+                          buffer_limits limits) {
+  constexpr size_t min_buffer_bytes = size_t{1} << 20;
+  while (!try_upload(vertices, edges, limits)) {
+    free();
+    if (limits.max_buffer_bytes <= min_buffer_bytes)
+      throw runtime_error(
+          "OpenGL Error: Failed to allocate buffers for the vertex data.");
+    limits.max_buffer_bytes /= 2;
+  }
+  create_vertex_arrays(0, vpos_location);
+}
+
+void line_batches::create_vertex_arrays(size_t view, GLint vpos_location) {
+  if (views_.size() <= view) views_.resize(view + 1);
+  delete_vertex_arrays(view);
+  const auto create = [&](const draw& d) {
+    GLuint vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, d.vertex_buffer);
+    glEnableVertexAttribArray(vpos_location);
+    glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec3), (void*)0);
+    if (d.element_buffer)
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, d.element_buffer);
+    return vertex_array;
+  };
+  auto& arrays = views_[view];
+  for (const auto& d : draws_) arrays.draws.push_back(create(d));
+  for (const auto& d : point_draws_) arrays.point_draws.push_back(create(d));
+}
+
+void line_batches::delete_vertex_arrays(size_t view) {
+  if (views_.size() <= view) return;
+  auto& arrays = views_[view];
+  glDeleteVertexArrays(arrays.draws.size(), arrays.draws.data());
+  glDeleteVertexArrays(arrays.point_draws.size(), arrays.point_draws.data());
+  arrays = {};
+}
+
+void line_batches::free() {
+  delete_vertex_arrays(0);
+  glDeleteBuffers(buffers_.size(), buffers_.data());
+  buffers_.clear();
+  buffer_memory_.set(0);
+  draws_.clear();
+  point_draws_.clear();
+  views_.clear();
+  block_buffers_.clear();
+  line_buffers_.clear();
+  duplicates_.clear();
+}
+
+void line_batches::update(span<const glm::vec3> vertices,
+                          size_t first,
+                          size_t last) {
+  if (block_buffers_.empty()) return;
+  for (auto b = first / block_size_; b * block_size_ < last; ++b) {
+    const auto begin = max(first, b * block_size_);
+    const auto end = min(last, (b + 1) * block_size_);
+    glBindBuffer(GL_ARRAY_BUFFER, block_buffers_[b]);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    (begin - b * block_size_) * sizeof(glm::vec3),
+                    (end - begin) * sizeof(glm::vec3), &vertices[begin]);
+  }
+
+  // Duplicates are written in runs of consecutive slots.
+  const auto less = [](const auto& x, uint64_t v) { return x.first < v; };
+  const auto lower =
+      lower_bound(duplicates_.begin(), duplicates_.end(), first, less);
+  const auto upper = lower_bound(lower, duplicates_.end(), last, less);
+  if (lower == upper) return;
+  vector<pair<uint64_t, uint64_t>> slots{};
+  for (auto it = lower; it != upper; ++it)
+    slots.emplace_back(it->second, it->first);
+  sort(slots.begin(), slots.end());
+  vector<glm::vec3> run{};
+  for (size_t i = 0; i < slots.size();) {
+    const auto piece = slots[i].first / line_piece_vertices_;
+    const auto start = slots[i].first;
+    run.clear();
+    do {
+      run.push_back(vertices[slots[i].second]);
+      ++i;
+    } while (i < slots.size() && slots[i].first == start + run.size() &&
+             slots[i].first / line_piece_vertices_ == piece);
+    glBindBuffer(GL_ARRAY_BUFFER, line_buffers_[piece]);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    (start - piece * line_piece_vertices_) * sizeof(glm::vec3),
+                    run.size() * sizeof(glm::vec3), run.data());
+  }
+}
+
+void line_batches::render_points(size_t view) const {
+  if (views_.size() <= view) return;
+  const auto& arrays = views_[view].point_draws;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    glBindVertexArray(arrays[i]);
+    glDrawArrays(GL_POINTS, 0, point_draws_[i].count);
+  }
+}
+
+void line_batches::render(size_t view) const {
+  if (views_.size() <= view) return;
+  const auto& arrays = views_[view].draws;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    const auto& d = draws_[i];
+    glBindVertexArray(arrays[i]);
+    if (d.element_buffer)
+      glDrawElements(GL_LINES, d.count, GL_UNSIGNED_INT, 0);
+    else
+      glDrawArrays(GL_LINES, 0, d.count);
+  }
+}
+
+bool line_batches::create_buffer(GLenum target, size_t size, const void* data) {
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  buffers_.push_back(buffer);
+  glBindBuffer(target, buffer);
+  // Clear previous errors to only get the error of the allocation.
+  while (glGetError() != GL_NO_ERROR) continue;
+  // The data is not changing rapidly. Therefore we use GL_STATIC_DRAW.
+  glBufferData(target, size, data, GL_STATIC_DRAW);
+  if (glGetError() == GL_OUT_OF_MEMORY) return false;
+  buffer_memory_.add(size);
+  return true;
+}
+
+bool line_batches::try_upload(span<const glm::vec3> vertices,
+                              vector<edge>& edges,
+                              const buffer_limits& limits) {
+  // Relative indices have to fit into 32 bits
+  // and draw counts into a signed 32-bit integer.
+  const size_t block_size = min({limits.max_buffer_bytes / sizeof(glm::vec3),
+                                 limits.max_vertices, size_t{INT_MAX}});
+  const size_t piece_size =
+      min({limits.max_buffer_bytes / sizeof(uint32_t), limits.max_indices,
+           size_t{INT_MAX}}) /
+      2;
+  const size_t block_count = (vertices.size() + block_size - 1) / block_size;
+
+  // Sort edges by their block. Crossing edges are put to the end.
+  const auto block = [&](const edge& e) {
+    const auto b = e.first / block_size;
+    return (b == e.second / block_size) ? b : block_count;
+  };
+  if (block_count > 1)
+    sort(begin(edges), end(edges),
+         [&](const edge& x, const edge& y) { return block(x) < block(y); });
+
+  vector<uint32_t> indices{};
+  auto e = begin(edges);
+  for (size_t b = 0; b < block_count; ++b) {
+    const auto first = b * block_size;
+    const auto count = min(block_size, vertices.size() - first);
+    if (!create_buffer(GL_ARRAY_BUFFER, count * sizeof(glm::vec3),
+                       &vertices[first]))
+      return false;
+    const auto vertex_buffer = buffers_.back();
+    block_buffers_.push_back(vertex_buffer);
+    point_draws_.push_back({vertex_buffer, 0, GLsizei(count)});
+
+    // Convert the edges of this block to relative 32-bit indices
+    // and split them into pieces with their own element buffer.
+    const auto last = find_if(e, end(edges),
+                              [&](const edge& x) { return block(x) != b; });
+    while (e != last) {
+      const auto n = min<size_t>(piece_size, last - e);
+      indices.resize(2 * n);
+      for (size_t i = 0; i < n; ++i, ++e) {
+        indices[2 * i + 0] = uint32_t(e->first - first);
+        indices[2 * i + 1] = uint32_t(e->second - first);
+      }
+      // Element buffers are filled through the array buffer target
+      // because their binding is part of the vertex array state.
+      if (!create_buffer(GL_ARRAY_BUFFER, indices.size() * sizeof(uint32_t),
+                         indices.data()))
+        return false;
+      draws_.push_back(
+          {vertex_buffer, buffers_.back(), GLsizei(indices.size())});
+    }
+  }
+  indices = {};
+
+  // Crossing edges duplicate their vertices and are drawn without indices.
+  vector<glm::vec3> lines{};
+  const size_t line_piece_size = min(piece_size, block_size / 2);
+  block_size_ = block_size;
+  line_piece_vertices_ = 2 * line_piece_size;
+  while (e != end(edges)) {
+    const auto n = min<size_t>(line_piece_size, end(edges) - e);
+    lines.resize(2 * n);
+    const uint64_t slot = line_buffers_.size() * line_piece_vertices_;
+    for (size_t i = 0; i < n; ++i, ++e) {
+      lines[2 * i + 0] = vertices[e->first];
+      lines[2 * i + 1] = vertices[e->second];
+      duplicates_.emplace_back(e->first, slot + 2 * i + 0);
+      duplicates_.emplace_back(e->second, slot + 2 * i + 1);
+    }
+    if (!create_buffer(GL_ARRAY_BUFFER, lines.size() * sizeof(glm::vec3),
+                       lines.data()))
+      return false;
+    line_buffers_.push_back(buffers_.back());
+    draws_.push_back({buffers_.back(), 0, GLsizei(lines.size())});
+  }
+  sort(begin(duplicates_), end(duplicates_));
+  return true;
+}
+
+}  // namespace vipo
@@ -0,0 +1,103 @@
+#pragma once
+// STL
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+//
+#include <glbinding/gl/gl.h>
+//
+#include <glm/glm.hpp>
+//
+#include "frontier_file.hpp"
+#include "memory_stats.hpp"
+
+namespace vipo {
+
+// Limits every single buffer and draw call has to stay inside.
+// OpenGL 3.3 cannot be queried for the maximum buffer size.
+// So it is given explicitly and reduced when allocation fails.
+struct buffer_limits {
+  size_t max_buffer_bytes = size_t{1} << 30;
+  size_t max_vertices = size_t{1} << 32;
+  size_t max_indices = size_t{1} << 31;
+};
+
+// Read GL_MAX_ELEMENTS_VERTICES and GL_MAX_ELEMENTS_INDICES
+// from the current OpenGL context. Both are only recommendations.
+// Tiny values reported by some software drivers are therefore
+// raised to a lower bound to not end up with millions of draw calls.
+buffer_limits query_buffer_limits();
+
+// GPU representation of lines given by vertices and 64-bit edges.
+// Vertices are split into blocks whose 32-bit relative indices
+// and buffer sizes stay inside the limits. Edges inside a block are
+// drawn indexed in multiple pieces. Edges crossing block boundaries
+// are rare for spatially coherent inputs and stored as unindexed lines.
+class line_batches {
+ public:
+  // Upload the lines and use the given limits as starting point.
+  // When the driver reports GL_OUT_OF_MEMORY, the buffer size limit
+  // is halved and the upload is repeated. Edges are reordered by block.
+  // The vertex arrays of view 0 are created in the current context.
+  // Throws 'std::runtime_error' if even small buffers cannot be allocated.
+  void upload(std::span<const glm::vec3> vertices,
+              std::vector<edge>& edges,
+              gl::GLint vpos_location,
+              buffer_limits limits);
+  // Write the vertices in [first, last) again after they have been modified.
+  // Only the affected parts of the vertex buffers and the duplicates of
+  // crossing edges are updated by 'glBufferSubData'. The number of
+  // vertices and the edges must not have changed since the upload.
+  void update(std::span<const glm::vec3> vertices, size_t first, size_t last);
+  // Vertex arrays cannot be shared between contexts. So every further
+  // context sharing the buffers needs its own vertex arrays. They have to
+  // be created and deleted while the context of the view is current.
+  void create_vertex_arrays(size_t view, gl::GLint vpos_location);
+  void delete_vertex_arrays(size_t view);
+  // Delete all buffers and the vertex arrays of view 0.
+  // Vertex arrays of further views have to be deleted before.
+  void free();
+  // Issue all draw calls of the lines.
+  void render(size_t view = 0) const;
+  // Issue one draw call per vertex block to show all vertices as points.
+  void render_points(size_t view = 0) const;
+
+  size_t draw_count() const noexcept { return draws_.size(); }
+  size_t buffer_count() const noexcept { return buffers_.size(); }
+
+ private:
+  bool try_upload(std::span<const glm::vec3> vertices,
+                  std::vector<edge>& edges,
+                  const buffer_limits& limits);
+  // Create a buffer for the given data and check for allocation failures.
+  bool create_buffer(gl::GLenum target, size_t size, const void* data);
+
+  struct draw {
+    gl::GLuint vertex_buffer;
+    // Unindexed draws have no element buffer.
+    gl::GLuint element_buffer;
+    gl::GLsizei count;
+  };
+  // Vertex arrays of a view in the order of the draws.
+  struct view_arrays {
+    std::vector<gl::GLuint> draws{};
+    std::vector<gl::GLuint> point_draws{};
+  };
+  std::vector<gl::GLuint> buffers_{};
+  std::vector<draw> draws_{};
+  std::vector<draw> point_draws_{};
+  std::vector<view_arrays> views_{};
+
+  // Data needed for partial updates
+  size_t block_size_ = 0;
+  std::vector<gl::GLuint> block_buffers_{};
+  size_t line_piece_vertices_ = 0;
+  std::vector<gl::GLuint> line_buffers_{};
+  // Pairs of a vertex index and the index of its duplicate
+  // in the unindexed lines of crossing edges sorted by vertex.
+  std::vector<std::pair<uint64_t, uint64_t>> duplicates_{};
+  memory_account buffer_memory_{memory_pool::gpu_lines};
+};
+
+}  // namespace vipo
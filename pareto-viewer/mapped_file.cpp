@@ -0,0 +1,57 @@
+#include "mapped_file.hpp"
+// STL
+#include <stdexcept>
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vipo {
+
+mapped_file::mapped_file(const string& path) {
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    throw runtime_error("Failed to open file '" + path + "' for reading.");
+  struct stat status;
+  if (fstat(fd, &status) == -1) {
+    close(fd);
+    throw runtime_error("Failed to get size of file '" + path + "'.");
+  }
+  size_ = status.st_size;
+  // Empty files cannot be mapped but are valid input.
+  if (size_ == 0) {
+    close(fd);
+    return;
+  }
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after closing the file descriptor.
+  close(fd);
+  if (data == MAP_FAILED)
+    throw runtime_error("Failed to map file '" + path + "' into memory.");
+  data_ = static_cast<const char*>(data);
+}
+
+mapped_file::~mapped_file() {
+  if (data_) munmap(const_cast<char*>(data_), size_);
+}
+
+void mapped_file::advise_sequential() const noexcept {
+  if (data_) madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+}
+
+void mapped_file::advise_random() const noexcept {
+  if (data_) madvise(const_cast<char*>(data_), size_, MADV_RANDOM);
+}
+
+void mapped_file::advise_will_need(size_t offset, size_t size) const noexcept {
+  constexpr size_t page_size = 4096;
+  if (!data_ || offset >= size_) return;
+  const auto first = offset / page_size * page_size;
+  const auto last = min(offset + size, size_);
+  madvise(const_cast<char*>(data_) + first, last - first, MADV_WILLNEED);
+}
+
+}  // namespace vipo
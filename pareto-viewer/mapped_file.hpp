@@ -0,0 +1,34 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace vipo {
+
+// Read-only memory mapping of a whole file.
+// Pages are only loaded by the OS when they are accessed.
+class mapped_file {
+ public:
+  // Throws 'std::runtime_error' if the file cannot be opened or mapped.
+  explicit mapped_file(const std::string& path);
+  ~mapped_file();
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  const char* data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+  std::string_view view() const noexcept { return {data_, size_}; }
+
+  // Hint the OS about the expected access pattern.
+  void advise_sequential() const noexcept;
+  void advise_random() const noexcept;
+  // Ask the OS to read the given byte range in the background.
+  void advise_will_need(size_t offset, size_t size) const noexcept;
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace vipo
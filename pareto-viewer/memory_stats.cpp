@@ -0,0 +1,108 @@
+#include "memory_stats.hpp"
+// STL
+#include <array>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+struct counter {
+  atomic<size_t> current = 0;
+  atomic<size_t> peak = 0;
+
+  void add(ptrdiff_t bytes) noexcept {
+    const auto value =
+        current.fetch_add(size_t(bytes), memory_order_relaxed) + bytes;
+    auto old = peak.load(memory_order_relaxed);
+    while (value > old &&
+           !peak.compare_exchange_weak(old, value, memory_order_relaxed))
+      continue;
+  }
+
+  memory_usage usage() const noexcept {
+    return {current.load(memory_order_relaxed),
+            peak.load(memory_order_relaxed)};
+  }
+};
+
+constexpr auto pool_count = size_t(memory_pool::count);
+array<counter, pool_count> pools{};
+counter cpu{};
+counter gpu{};
+atomic<size_t> allocations = 0;
+
+string mebibytes(size_t bytes) {
+  stringstream stream{};
+  stream << fixed << setprecision(1) << bytes / double(1 << 20) << " MiB";
+  return stream.str();
+}
+
+}  // namespace
+
+bool is_gpu(memory_pool pool) noexcept {
+  return pool >= memory_pool::gpu_lines;
+}
+
+const char* name(memory_pool pool) noexcept {
+  constexpr array<const char*, pool_count> names{
+      "parse buffers", "frontier", "indices",    "vertices",   "surface",
+      "cache",         "GPU lines", "GPU chunks", "GPU surface", "GPU frames"};
+  return names[size_t(pool)];
+}
+
+void account_memory(memory_pool pool, ptrdiff_t bytes) noexcept {
+  if (bytes == 0) return;
+  pools[size_t(pool)].add(bytes);
+  (is_gpu(pool) ? gpu : cpu).add(bytes);
+}
+
+memory_usage memory_usage_of(memory_pool pool) noexcept {
+  return pools[size_t(pool)].usage();
+}
+
+memory_usage cpu_memory_usage() noexcept {
+  return cpu.usage();
+}
+
+memory_usage gpu_memory_usage() noexcept {
+  return gpu.usage();
+}
+
+void count_allocation() noexcept {
+  allocations.fetch_add(1, memory_order_relaxed);
+}
+
+size_t allocation_count() noexcept {
+  return allocations.load(memory_order_relaxed);
+}
+
+string memory_report() {
+  stringstream report{};
+  const auto row = [&](const char* name, const memory_usage& usage) {
+    report << left << setw(16) << name << right << setw(14)
+           << mebibytes(usage.current) << setw(14) << mebibytes(usage.peak)
+           << '\n';
+  };
+  report << left << setw(16) << "memory" << right << setw(14) << "current"
+         << setw(14) << "peak" << '\n';
+  for (size_t i = 0; i < pool_count; ++i)
+    row(name(memory_pool(i)), memory_usage_of(memory_pool(i)));
+  row("CPU total", cpu_memory_usage());
+  row("GPU total", gpu_memory_usage());
+  return report.str();
+}
+
+string memory_summary() {
+  const auto c = cpu_memory_usage();
+  const auto g = gpu_memory_usage();
+  return "CPU " + mebibytes(c.current) + " (peak " + mebibytes(c.peak) +
+         "), GPU " + mebibytes(g.current) + " (peak " + mebibytes(g.peak) +
+         ")";
+}
+
+}  // namespace vipo
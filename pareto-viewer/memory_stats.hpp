@@ -0,0 +1,80 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <string>
+
+namespace vipo {
+
+// Subsystems whose memory is accounted. Mapped files are not included
+// because the OS can drop their pages at any time, except for the cache.
+enum class memory_pool {
+  // CPU: blocks of decompressed text waiting to be parsed
+  parse_buffers,
+  // CPU: objectives of loaded frontiers
+  frontier,
+  // CPU: edges of loaded frontiers and their copies for the upload
+  indices,
+  // CPU: float vertices mapped from objectives by the viewer
+  vertices,
+  // CPU: triangles of the attainment surface
+  surface,
+  // CPU: mapped entries of the cache of derived data
+  cache,
+  // GPU: vertex and element buffers of the lines
+  gpu_lines,
+  // GPU: buffer pool of chunks in out-of-core mode
+  gpu_chunks,
+  // GPU: buffers of the attainment surface
+  gpu_surface,
+  // GPU: textures of frames received from a render server
+  gpu_frames,
+  count
+};
+
+bool is_gpu(memory_pool pool) noexcept;
+const char* name(memory_pool pool) noexcept;
+
+struct memory_usage {
+  size_t current = 0;
+  size_t peak = 0;
+};
+
+// Add or remove bytes of a pool. The counters are atomic.
+// Peaks are tracked per pool and for the totals of CPU and GPU.
+void account_memory(memory_pool pool, ptrdiff_t bytes) noexcept;
+memory_usage memory_usage_of(memory_pool pool) noexcept;
+memory_usage cpu_memory_usage() noexcept;
+memory_usage gpu_memory_usage() noexcept;
+
+// Number of blocks allocated by parse arenas and of large arrays.
+// Small allocations of other containers are not counted.
+void count_allocation() noexcept;
+size_t allocation_count() noexcept;
+
+// Table of the current and peak bytes of all pools.
+std::string memory_report();
+// One line with the totals of CPU and GPU, e.g. for a window title.
+std::string memory_summary();
+
+// Bytes of one owner in a pool. The owner sets its current size
+// after every change. They are released when the account is destroyed.
+class memory_account {
+ public:
+  explicit memory_account(memory_pool pool) noexcept : pool_{pool} {}
+  ~memory_account() { set(0); }
+  memory_account(const memory_account&) = delete;
+  memory_account& operator=(const memory_account&) = delete;
+
+  void set(size_t bytes) noexcept {
+    account_memory(pool_, ptrdiff_t(bytes) - ptrdiff_t(bytes_));
+    bytes_ = bytes;
+  }
+  void add(size_t bytes) noexcept { set(bytes_ + bytes); }
+  size_t bytes() const noexcept { return bytes_; }
+
+ private:
+  memory_pool pool_;
+  size_t bytes_ = 0;
+};
+
+}  // namespace vipo
@@ -0,0 +1,280 @@
+#include "npy_file.hpp"
+// STL
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+//
+#include "strided_gather.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+// Read a little-endian integer from an arbitrary address.
+template <typename T>
+inline T read_le(const char* p) noexcept {
+  T x;
+  memcpy(&x, p, sizeof(T));
+  return x;
+}
+
+// Return the value of the given key of the Python dictionary literal
+// in the header up to the next comma on the same nesting level.
+string_view header_value(string_view header, string_view key) {
+  const auto k = header.find("'" + string(key) + "'");
+  if (k == string_view::npos)
+    throw runtime_error("Failed to find '" + string(key) +
+                        "' in NumPy header.");
+  auto value = header.substr(header.find(':', k) + 1);
+  int depth = 0;
+  size_t last = 0;
+  for (; last < value.size(); ++last) {
+    const auto c = value[last];
+    if (c == '(' || c == '[') ++depth;
+    if (c == ')' || c == ']') --depth;
+    if ((c == ',' && depth == 0) || c == '}') break;
+  }
+  value = value.substr(0, last);
+  while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+  while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+  return value;
+}
+
+scalar_type element_type(const npy_array& array) {
+  const auto log_size = countr_zero(array.item_size);
+  if (array.kind == 'f')
+    return array.item_size == 4 ? scalar_type::float32 : scalar_type::float64;
+  // Signed and unsigned types alternate in the enumeration.
+  return scalar_type(2 * log_size + (array.kind == 'u'));
+}
+
+}  // namespace
+
+npy_array parse_npy(const char* data, size_t size) {
+  constexpr char magic[] = "\x93NUMPY";
+  if (size < 10 || memcmp(data, magic, 6) != 0)
+    throw runtime_error("Failed to parse NumPy file. Magic string is missing.");
+  const auto major = uint8_t(data[6]);
+  size_t header_offset = 10;
+  size_t header_size = read_le<uint16_t>(data + 8);
+  if (major >= 2) {
+    if (size < 12)
+      throw runtime_error("Failed to parse NumPy file. Header is truncated.");
+    header_offset = 12;
+    header_size = read_le<uint32_t>(data + 8);
+  }
+  if (header_offset + header_size > size)
+    throw runtime_error("Failed to parse NumPy file. Header is truncated.");
+  const string_view header{data + header_offset, header_size};
+
+  npy_array array{};
+  // Element Type
+  auto descr = header_value(header, "descr");
+  if (descr.size() < 5 || descr.front() != '\'' || descr.back() != '\'')
+    throw runtime_error("Failed to parse NumPy file. Structured types like " +
+                        string(descr) + " are not supported.");
+  descr = descr.substr(1, descr.size() - 2);
+  array.little_endian = descr[0] == '<' || descr[0] == '|' ||
+                        (descr[0] == '=' && endian::native == endian::little);
+  array.kind = descr[1];
+  from_chars(descr.data() + 2, descr.data() + descr.size(), array.item_size);
+  const bool supported =
+      (array.kind == 'f' && (array.item_size == 4 || array.item_size == 8)) ||
+      ((array.kind == 'i' || array.kind == 'u') &&
+       (array.item_size == 1 || array.item_size == 2 ||
+        array.item_size == 4 || array.item_size == 8));
+  if (!supported)
+    throw runtime_error("Failed to parse NumPy file. Type '" + string(descr) +
+                        "' is not supported.");
+
+  // Memory Order
+  array.fortran_order = header_value(header, "fortran_order") == "True";
+
+  // Shape
+  auto shape = header_value(header, "shape");
+  vector<size_t> extents{};
+  for (size_t i = 0; i < shape.size();) {
+    if (!isdigit(shape[i])) {
+      ++i;
+      continue;
+    }
+    size_t extent;
+    const auto [ptr, error] =
+        from_chars(shape.data() + i, shape.data() + shape.size(), extent);
+    extents.push_back(extent);
+    i = ptr - shape.data();
+  }
+  if (extents.size() != 2)
+    throw runtime_error("Failed to parse NumPy file. Shape " + string(shape) +
+                        " is not two-dimensional.");
+  array.rows = extents[0];
+  array.columns = extents[1];
+
+  array.data = data + header_offset + header_size;
+  // The size is compared by division such that huge shapes do not overflow.
+  const auto items = (size - header_offset - header_size) / array.item_size;
+  if (array.columns != 0 &&
+      (array.columns > items || array.rows > items / array.columns))
+    throw runtime_error("Failed to parse NumPy file. Data is truncated.");
+  return array;
+}
+
+npy_array find_npz_array(const char* data, size_t size, const string& name) {
+  // Find the end of central directory record by scanning backwards.
+  constexpr size_t eocd_size = 22;
+  if (size < eocd_size)
+    throw runtime_error("Failed to parse NumPy archive. File is too small.");
+  size_t eocd = size - eocd_size;
+  const size_t lower = (size > eocd_size + 0xffff) ? eocd - 0xffff : 0;
+  while (read_le<uint32_t>(data + eocd) != 0x06054b50) {
+    if (eocd == lower)
+      throw runtime_error("Failed to parse NumPy archive. Not a ZIP file.");
+    --eocd;
+  }
+  const auto broken = [] {
+    throw runtime_error("Failed to parse NumPy archive. Directory is broken.");
+  };
+  uint64_t entries = read_le<uint16_t>(data + eocd + 10);
+  uint64_t directory = read_le<uint32_t>(data + eocd + 16);
+  // Large archives use the ZIP64 end of central directory record.
+  if (directory == 0xffffffff && eocd >= 20 &&
+      read_le<uint32_t>(data + eocd - 20) == 0x07064b50) {
+    const auto record = read_le<uint64_t>(data + eocd - 20 + 8);
+    // The record of 56 bytes lies in front of its locator.
+    if (record > eocd - 20 || eocd - 20 - record < 56) broken();
+    entries = read_le<uint64_t>(data + record + 32);
+    directory = read_le<uint64_t>(data + record + 48);
+  }
+  if (directory > size) broken();
+
+  // Entry with the wanted name or, if no name is given,
+  // the first stored entry as fallback.
+  struct zip_entry {
+    string_view name{};
+    uint16_t method = 0;
+    uint64_t local = 0;
+  };
+  const auto wanted = name.empty() ? string("F.npy") : name + ".npy";
+  optional<zip_entry> fallback{};
+  optional<zip_entry> found{};
+  // Offsets are compared with the remaining size such that they cannot
+  // point outside of the mapping or overflow.
+  size_t position = directory;
+  for (uint64_t i = 0; i < entries; ++i) {
+    const auto p = data + position;
+    if (size - position < 46 || read_le<uint32_t>(p) != 0x02014b50) broken();
+    const auto method = read_le<uint16_t>(p + 10);
+    uint64_t local = read_le<uint32_t>(p + 42);
+    const size_t name_size = read_le<uint16_t>(p + 28);
+    const size_t extra_size = read_le<uint16_t>(p + 30);
+    const size_t comment_size = read_le<uint16_t>(p + 32);
+    const auto entry_size = 46 + name_size + extra_size + comment_size;
+    if (size - position < entry_size) broken();
+    const string_view entry{p + 46, name_size};
+    // The ZIP64 extra field stores all sizes that did not fit into 32 bits.
+    if (local == 0xffffffff) {
+      const auto extra_end = p + 46 + name_size + extra_size;
+      for (auto e = p + 46 + name_size; e != extra_end;) {
+        if (extra_end - e < 4) broken();
+        const auto id = read_le<uint16_t>(e);
+        const size_t extra = read_le<uint16_t>(e + 2);
+        if (size_t(extra_end - e - 4) < extra) broken();
+        if (id == 0x0001) {
+          size_t field = 4;
+          if (read_le<uint32_t>(p + 24) == 0xffffffff) field += 8;
+          if (read_le<uint32_t>(p + 20) == 0xffffffff) field += 8;
+          if (field + 8 > 4 + extra) broken();
+          local = read_le<uint64_t>(e + field);
+        }
+        e += 4 + extra;
+      }
+    }
+    if (entry == wanted) {
+      found = zip_entry{entry, method, local};
+      break;
+    }
+    // Compressed entries cannot be mapped and are no fallback.
+    if (!fallback && name.empty() && method == 0)
+      fallback = zip_entry{entry, method, local};
+    position += entry_size;
+  }
+  if (!found) found = fallback;
+  if (!found)
+    throw runtime_error("Failed to find array '" + wanted +
+                        "' in NumPy archive.");
+  if (found->method != 0)
+    throw runtime_error("Failed to map NumPy archive entry '" +
+                        string(found->name) +
+                        "'. Compressed archives are not supported.");
+  if (size < 30 || found->local > size - 30)
+    throw runtime_error("Failed to parse NumPy archive. Entry is truncated.");
+  const auto local_header = data + found->local;
+  const size_t offset = 30 + read_le<uint16_t>(local_header + 26) +
+                        read_le<uint16_t>(local_header + 28);
+  if (offset > size - found->local)
+    throw runtime_error("Failed to parse NumPy archive. Entry is truncated.");
+  const auto entry_data = local_header + offset;
+  return parse_npy(entry_data, data + size - entry_data);
+}
+
+std::array<size_t, 3> select_npy_columns(const npy_array& array,
+                                         const vector<string>& columns) {
+  std::array<size_t, 3> result{0, 1, 2};
+  if (!columns.empty()) {
+    if (columns.size() != 3)
+      throw runtime_error("Exactly three array columns have to be selected.");
+    for (int k = 0; k < 3; ++k) {
+      const auto& c = columns[k];
+      const auto [ptr, error] =
+          from_chars(c.data(), c.data() + c.size(), result[k]);
+      if (error != errc{} || ptr != c.data() + c.size())
+        throw runtime_error("Array column '" + c + "' is not an index.");
+    }
+  }
+  for (auto c : result)
+    if (c >= array.columns)
+      throw runtime_error("Array column " + to_string(c) +
+                          " does not exist. The array has only " +
+                          to_string(array.columns) + " columns.");
+  return result;
+}
+
+span<const glm::vec3> view_npy_vertices(const npy_array& array,
+                                        const std::array<size_t, 3>& columns) {
+  static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+  if (array.kind != 'f' || array.item_size != sizeof(float) ||
+      array.little_endian != (endian::native == endian::little) ||
+      array.columns != 3 || (array.fortran_order && array.rows > 1) ||
+      columns != std::array<size_t, 3>{0, 1, 2} ||
+      reinterpret_cast<uintptr_t>(array.data) % alignof(glm::vec3) != 0)
+    return {};
+  return {reinterpret_cast<const glm::vec3*>(array.data), array.rows};
+}
+
+void convert_npy(const npy_array& array,
+                 const std::array<size_t, 3>& columns,
+                 large_vector<glm::dvec3>& objectives) {
+  const auto type = element_type(array);
+  const auto size = array.item_size;
+  const auto swap = array.little_endian != (endian::native == endian::little);
+  // Distance of two consecutive rows and of two consecutive columns.
+  const auto row_stride = array.fortran_order ? size : array.columns * size;
+  const auto column_stride = array.fortran_order ? array.rows * size : size;
+
+  const auto offset = objectives.size();
+  objectives.resize(offset + array.rows);
+  if (array.rows == 0) return;
+  for (int k = 0; k < 3; ++k)
+    gather(type, array.data + columns[k] * column_stride, row_stride,
+           array.rows, swap, &objectives[offset][k], 3);
+}
+
+}  // namespace vipo
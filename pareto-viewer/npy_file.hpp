@@ -0,0 +1,59 @@
+#pragma once
+// STL
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "large_array.hpp"
+
+namespace vipo {
+
+// Description of a NumPy array stored in a memory-mapped file.
+struct npy_array {
+  // Kind of the element type: 'f' float, 'i' signed, 'u' unsigned integer.
+  char kind = 'f';
+  size_t item_size = 4;
+  bool little_endian = true;
+  bool fortran_order = false;
+  size_t rows = 0;
+  size_t columns = 0;
+  const char* data = nullptr;
+};
+
+// Parse the header of an .npy file given as memory range.
+// Only two-dimensional arrays of numbers are supported.
+// Throws 'std::runtime_error' for malformed or unsupported headers.
+npy_array parse_npy(const char* data, size_t size);
+
+// Find the array with the given name in an .npz archive.
+// Only stored entries can be mapped. Compressed archives created with
+// 'numpy.savez_compressed' are not supported. If the name is empty,
+// 'F' is taken if it exists and the first array otherwise.
+npy_array find_npz_array(const char* data,
+                         size_t size,
+                         const std::string& name);
+
+// Select three columns of the array given by zero-based indices.
+// If none are given, the first three columns are used.
+std::array<size_t, 3> select_npy_columns(
+    const npy_array& array,
+    const std::vector<std::string>& columns);
+
+// A C-order float32 array with exactly the three selected columns
+// is viewed as vertices without copying. Returns an empty span otherwise.
+std::span<const glm::vec3> view_npy_vertices(
+    const npy_array& array,
+    const std::array<size_t, 3>& columns);
+
+// Convert the selected columns of an array with arbitrary element type
+// and order to double precision. Rows are processed in parallel chunks
+// by loops specialized for every element type.
+void convert_npy(const npy_array& array,
+                 const std::array<size_t, 3>& columns,
+                 large_vector<glm::dvec3>& objectives);
+
+}  // namespace vipo
@@ -0,0 +1,22 @@
+#include "obj_file.hpp"
+//
+#include "mapped_file.hpp"
+#include "text_frontier.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+void load_obj(const string& path,
+              large_vector<glm::dvec3>& objectives,
+              large_vector<edge>& edges) {
+  const mapped_file file{path};
+  file.advise_sequential();
+  parse_text_lines(file.data(), file.data() + file.size(), 1,
+                   text_dialect::obj, objectives, edges);
+  // Polylines and polygons may share their segments.
+  remove_duplicate_edges(edges);
+  check_edges(path, objectives.size(), edges);
+}
+
+}  // namespace vipo
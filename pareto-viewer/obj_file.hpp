@@ -0,0 +1,24 @@
+#pragma once
+// STL
+#include <string>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "frontier_file.hpp"
+
+namespace vipo {
+
+// Load the subset of a Wavefront OBJ file that describes a Pareto frontier.
+// Vertices are given by 'v' records with optional additional values.
+// Polylines of 'l' records and polygon boundaries of 'f' records become
+// edges. Indices are one-based. Negative indices are relative to the last
+// vertex defined so far. Texture and normal references like '1/2/3' are
+// ignored as are comments and all other records. The file is parsed
+// in parallel chunks. Throws 'std::runtime_error' with the line number
+// for malformed values and invalid indices.
+void load_obj(const std::string& path,
+              large_vector<glm::dvec3>& objectives,
+              large_vector<edge>& edges);
+
+}  // namespace vipo
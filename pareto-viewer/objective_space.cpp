@@ -0,0 +1,70 @@
+#include "objective_space.hpp"
+// STL
+#include <limits>
+//
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+template <typename vector_type>
+objective_bounds bounds_of(span<const vector_type> objectives) {
+  constexpr auto infinity = numeric_limits<double>::infinity();
+  const auto n = objectives.size();
+  vector<objective_bounds> chunks(
+      parallel_chunk_count(n),
+      {glm::dvec3{infinity}, glm::dvec3{-infinity}, glm::dvec3{infinity}});
+  parallel_chunks(n, [&](size_t first, size_t last, size_t chunk) {
+    auto bounds = chunks[chunk];
+    for (size_t i = first; i < last; ++i) {
+      const auto x = glm::dvec3(objectives[i]);
+      bounds.min = min(bounds.min, x);
+      bounds.max = max(bounds.max, x);
+      for (int k = 0; k < 3; ++k)
+        if (x[k] > 0)
+          bounds.min_positive[k] = std::min(bounds.min_positive[k], x[k]);
+    }
+    chunks[chunk] = bounds;
+  });
+  auto bounds = chunks[0];
+  for (size_t i = 1; i < chunks.size(); ++i) {
+    bounds.min = min(bounds.min, chunks[i].min);
+    bounds.max = max(bounds.max, chunks[i].max);
+    bounds.min_positive = min(bounds.min_positive, chunks[i].min_positive);
+  }
+  return bounds;
+}
+
+}  // namespace
+
+objective_bounds compute_objective_bounds(span<const glm::dvec3> objectives) {
+  return bounds_of(objectives);
+}
+
+objective_bounds compute_objective_bounds(span<const glm::vec3> objectives) {
+  return bounds_of(objectives);
+}
+
+objective_transform fit_objective_transform(const objective_bounds& bounds) {
+  objective_transform transform{};
+  transform.center = 0.5 * (bounds.min + bounds.max);
+  const auto radius = 0.5 * (bounds.max - bounds.min);
+  for (int k = 0; k < 3; ++k)
+    transform.scale[k] = (radius[k] > 0) ? 1.0 / radius[k] : 1.0;
+  return transform;
+}
+
+void transform_objectives(span<const glm::dvec3> objectives,
+                          const objective_transform& transform,
+                          large_vector<glm::vec3>& vertices) {
+  vertices.resize(objectives.size());
+  parallel_chunks(objectives.size(), [&](size_t first, size_t last, size_t) {
+    for (size_t i = first; i < last; ++i)
+      vertices[i] = transform.to_render(objectives[i]);
+  });
+}
+
+}  // namespace vipo
@@ -0,0 +1,53 @@
+#pragma once
+// STL
+#include <span>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "large_array.hpp"
+
+namespace vipo {
+
+// Objective values are stored in double precision.
+// Large values with tiny differences, like 1e9 with spreads of 1e-3,
+// would be destroyed by a direct conversion to float.
+// Therefore, they are recentered at the center of their bounding box
+// and scaled to [-1, 1] before converting them to floats for the GPU.
+struct objective_transform {
+  glm::dvec3 center{0.0};
+  glm::dvec3 scale{1.0};
+
+  glm::vec3 to_render(const glm::dvec3& x) const noexcept {
+    return glm::vec3((x - center) * scale);
+  }
+  glm::dvec3 to_objective(const glm::vec3& x) const noexcept {
+    return glm::dvec3(x) / scale + center;
+  }
+};
+
+// Per-axis bounds of the objectives. The smallest positive value
+// is needed for logarithmic axes and is infinity if there is none.
+struct objective_bounds {
+  glm::dvec3 min{0.0};
+  glm::dvec3 max{0.0};
+  glm::dvec3 min_positive{0.0};
+};
+
+// Compute all bounds of the objectives in one parallel pass.
+objective_bounds compute_objective_bounds(
+    std::span<const glm::dvec3> objectives);
+// Compute all bounds of objectives given as float vertices.
+objective_bounds compute_objective_bounds(
+    std::span<const glm::vec3> objectives);
+
+// Return the transform mapping the bounding box onto [-1, 1]^3.
+// Degenerated axes are only recentered.
+objective_transform fit_objective_transform(const objective_bounds& bounds);
+
+// Transform all objectives in parallel chunks into render space.
+void transform_objectives(std::span<const glm::dvec3> objectives,
+                          const objective_transform& transform,
+                          large_vector<glm::vec3>& vertices);
+
+}  // namespace vipo
@@ -0,0 +1,384 @@
+#include "out_of_core.hpp"
+// STL
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+//
+#include "text_frontier.hpp"
+
+using namespace std;
+using namespace gl;
+
+namespace vipo {
+
+namespace {
+
+// Read all vertices of a Pareto frontier text file in blocks
+// and call the given function for every full or final block.
+// The mapped file is parsed part by part with the checked parser
+// of text frontiers. So malformed lines are reported with their number
+// and memory stays bounded by the block size. Objectives are parsed
+// in double precision and only rounded to floats for the chunks.
+template <typename function>
+void for_each_vertex_block(const string& path,
+                           size_t block_size,
+                           function&& f) {
+  const mapped_file file{path};
+  file.advise_sequential();
+  // The shortest vertex line 'v 0 0 0' has eight bytes.
+  // So a part never contains more vertices than a block.
+  const auto part_size = block_size * 8;
+  vector<glm::vec3> block{};
+  block.reserve(block_size);
+  large_vector<glm::dvec3> objectives{};
+  large_vector<edge> edges{};
+  size_t line = 1;
+  const auto end = file.data() + file.size();
+  for (auto first = file.data(); first != end;) {
+    // Parts end at line boundaries.
+    auto last = first + min<size_t>(part_size, end - first);
+    if (last != end) {
+      const auto newline =
+          static_cast<const char*>(memchr(last, '\n', end - last));
+      last = newline ? newline + 1 : end;
+    }
+    objectives.clear();
+    edges.clear();
+    line += parse_text_lines(first, last, line, text_dialect::native,
+                             objectives, edges);
+    for (const auto& x : objectives) {
+      block.push_back(glm::vec3(x));
+      if (block.size() == block_size) {
+        f(block);
+        block.clear();
+      }
+    }
+    first = last;
+  }
+  if (!block.empty()) f(block);
+}
+
+// Spread the lower 21 bits of x such that two zero bits
+// are inserted between every pair of consecutive bits.
+inline uint64_t spread_bits(uint64_t x) noexcept {
+  x &= 0x1fffff;
+  x = (x | x << 32) & 0x001f00000000ffff;
+  x = (x | x << 16) & 0x001f0000ff0000ff;
+  x = (x | x << 8) & 0x100f00f00f00f00f;
+  x = (x | x << 4) & 0x10c30c30c30c30c3;
+  x = (x | x << 2) & 0x1249249249249249;
+  return x;
+}
+
+inline uint64_t morton_code(const glm::vec3& v,
+                            const glm::vec3& aabb_min,
+                            const glm::vec3& scale) noexcept {
+  const auto q = glm::clamp((v - aabb_min) * scale, 0.0f, float(0x1fffff));
+  return spread_bits(uint64_t(q.x)) | spread_bits(uint64_t(q.y)) << 1 |
+         spread_bits(uint64_t(q.z)) << 2;
+}
+
+}  // namespace
+
+bool is_chunked_frontier(const string& path) {
+  fstream file{path, ios::in | ios::binary};
+  char magic[sizeof(chunked_frontier_header::magic)]{};
+  file.read(magic, sizeof(magic));
+  return file && memcmp(magic, chunked_frontier_header::magic_string,
+                        sizeof(magic)) == 0;
+}
+
+void write_chunked_frontier(const string& input,
+                            const string& output,
+                            uint32_t chunk_capacity,
+                            size_t block_size) {
+  // Blocks have to consist of full chunks.
+  block_size = max<size_t>(block_size / chunk_capacity, 1) * chunk_capacity;
+
+  // First Pass: Compute bounds and count vertices.
+  chunked_frontier_header header{};
+  memcpy(header.magic, chunked_frontier_header::magic_string,
+         sizeof(header.magic));
+  header.version = 1;
+  header.chunk_capacity = chunk_capacity;
+  header.aabb_min = glm::vec3{numeric_limits<float>::infinity()};
+  header.aabb_max = glm::vec3{-numeric_limits<float>::infinity()};
+  for_each_vertex_block(input, block_size, [&](const auto& block) {
+    for (const auto& v : block) {
+      header.aabb_min = min(header.aabb_min, v);
+      header.aabb_max = max(header.aabb_max, v);
+    }
+    header.vertex_count += block.size();
+    header.chunk_count += (block.size() + chunk_capacity - 1) / chunk_capacity;
+  });
+  if (header.vertex_count == 0)
+    throw runtime_error("Failed to convert file '" + input +
+                        "'. It does not contain any vertices.");
+
+  // Vertex data starts page-aligned after the chunk table.
+  constexpr uint64_t page_size = 4096;
+  header.data_offset =
+      (sizeof(header) + header.chunk_count * sizeof(chunk_info) + page_size -
+       1) /
+      page_size * page_size;
+
+  fstream file{output, ios::out | ios::binary | ios::trunc};
+  if (!file.is_open())
+    throw runtime_error("Failed to open file '" + output + "' for writing.");
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  // Second Pass: Sort every block along the Morton curve
+  // and split it into chunks with their own bounding boxes.
+  const auto extent = header.aabb_max - header.aabb_min;
+  const auto scale = float(0x1fffff) / max(extent, glm::vec3{1e-30f});
+  vector<chunk_info> chunks{};
+  chunks.reserve(header.chunk_count);
+  uint64_t offset = header.data_offset;
+  file.seekp(offset);
+  vector<pair<uint64_t, glm::vec3>> keys{};
+  for_each_vertex_block(input, block_size, [&](const auto& block) {
+    keys.resize(block.size());
+    for (size_t i = 0; i < block.size(); ++i)
+      keys[i] = {morton_code(block[i], header.aabb_min, scale), block[i]};
+    sort(begin(keys), end(keys),
+         [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    for (size_t first = 0; first < keys.size(); first += chunk_capacity) {
+      const auto last = min<size_t>(first + chunk_capacity, keys.size());
+      chunk_info chunk{};
+      chunk.offset = offset;
+      chunk.count = uint32_t(last - first);
+      chunk.aabb_min = keys[first].second;
+      chunk.aabb_max = keys[first].second;
+      for (size_t i = first; i < last; ++i) {
+        chunk.aabb_min = min(chunk.aabb_min, keys[i].second);
+        chunk.aabb_max = max(chunk.aabb_max, keys[i].second);
+        file.write(reinterpret_cast<const char*>(&keys[i].second),
+                   sizeof(glm::vec3));
+      }
+      offset += chunk.count * sizeof(glm::vec3);
+      chunks.push_back(chunk);
+    }
+  });
+
+  file.seekp(sizeof(header));
+  file.write(reinterpret_cast<const char*>(chunks.data()),
+             chunks.size() * sizeof(chunk_info));
+  if (!file)
+    throw runtime_error("Failed to write file '" + output + "'.");
+}
+
+chunked_frontier::chunked_frontier(const string& path) : file_{path} {
+  // Chunks are accessed in spatial and not in sequential order.
+  file_.advise_random();
+  header_ = reinterpret_cast<const chunked_frontier_header*>(file_.data());
+  chunks_ =
+      reinterpret_cast<const chunk_info*>(file_.data() + sizeof(*header_));
+  // The size of the chunk table is compared by division to not overflow.
+  if (file_.size() < sizeof(*header_) ||
+      memcmp(header_->magic, chunked_frontier_header::magic_string,
+             sizeof(header_->magic)) != 0 ||
+      header_->version != 1 ||
+      header_->chunk_count >
+          (file_.size() - sizeof(*header_)) / sizeof(chunk_info))
+    throw runtime_error("File '" + path + "' is not a valid chunked frontier.");
+  // Chunks are read from the mapping and uploaded into slots of the pool.
+  // So every chunk has to be inside of the file and fit into a slot.
+  for (size_t i = 0; i < header_->chunk_count; ++i) {
+    const auto& c = chunks_[i];
+    if (c.count > header_->chunk_capacity || c.offset > file_.size() ||
+        c.offset % alignof(glm::vec3) != 0 ||
+        c.count > (file_.size() - c.offset) / sizeof(glm::vec3))
+      throw runtime_error("File '" + path +
+                          "' is not a valid chunked frontier. Chunk " +
+                          to_string(i) + " is out of bounds.");
+  }
+}
+
+void chunked_frontier::prefetch(size_t i) const noexcept {
+  constexpr size_t page_size = 4096;
+  const auto& c = chunks_[i];
+  const auto size = c.count * sizeof(glm::vec3);
+  file_.advise_will_need(c.offset, size);
+  // Touch every page to make sure it is resident.
+  volatile char sink = 0;
+  const auto first = c.offset / page_size * page_size;
+  for (auto p = first; p < c.offset + size; p += page_size)
+    sink = sink + file_.data()[p];
+}
+
+chunk_streamer::chunk_streamer(const chunked_frontier& frontier,
+                               size_t slot_count)
+    : frontier_{frontier}, slot_count_{slot_count} {
+  free_slots_.reserve(slot_count_);
+  for (size_t i = slot_count_; i-- > 0;) free_slots_.push_back(i);
+  prefetcher_ = thread{[this] { prefetch_loop(); }};
+}
+
+chunk_streamer::~chunk_streamer() {
+  done_ = true;
+  condition_.notify_one();
+  prefetcher_.join();
+}
+
+void chunk_streamer::init(GLint vpos_location) {
+  const auto capacity = frontier_.header().chunk_capacity;
+  glGenVertexArrays(1, &vertex_array_);
+  glBindVertexArray(vertex_array_);
+  glGenBuffers(1, &vertex_buffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+  // The pool is written every frame. Therefore we use GL_DYNAMIC_DRAW.
+  const auto bytes = slot_count_ * capacity * sizeof(glm::vec3);
+  glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+  buffer_memory_.set(bytes);
+  glEnableVertexAttribArray(vpos_location);
+  glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE,
+                        sizeof(glm::vec3), (void*)0);
+}
+
+void chunk_streamer::free() {
+  glDeleteBuffers(1, &vertex_buffer_);
+  glDeleteVertexArrays(1, &vertex_array_);
+  buffer_memory_.set(0);
+}
+
+vector<size_t> chunk_streamer::visible_chunks(const glm::mat4& mvp) const {
+  // Extract the frustum planes in object space from the rows of the matrix.
+  const auto row = [&](int i) {
+    return glm::vec4{mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]};
+  };
+  const array<glm::vec4, 6> planes{row(3) + row(0), row(3) - row(0),
+                                   row(3) + row(1), row(3) - row(1),
+                                   row(3) + row(2), row(3) - row(2)};
+
+  vector<pair<float, size_t>> visible{};
+  for (size_t i = 0; i < frontier_.chunk_count(); ++i) {
+    const auto& c = frontier_.chunk(i);
+    bool inside = true;
+    for (const auto& p : planes) {
+      // Only test the corner of the box furthest along the plane normal.
+      const glm::vec3 corner{(p.x >= 0) ? c.aabb_max.x : c.aabb_min.x,
+                             (p.y >= 0) ? c.aabb_max.y : c.aabb_min.y,
+                             (p.z >= 0) ? c.aabb_max.z : c.aabb_min.z};
+      if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0) {
+        inside = false;
+        break;
+      }
+    }
+    if (!inside) continue;
+    // Sort by the clip-space w coordinate of the center which is the depth.
+    const auto center = 0.5f * (c.aabb_min + c.aabb_max);
+    const auto w = row(3);
+    visible.push_back(
+        {w.x * center.x + w.y * center.y + w.z * center.z + w.w, i});
+  }
+  sort(begin(visible), end(visible));
+
+  vector<size_t> result(visible.size());
+  for (size_t i = 0; i < visible.size(); ++i) result[i] = visible[i].second;
+  return result;
+}
+
+void chunk_streamer::update(const glm::mat4& mvp,
+                            const glm::mat4& predicted_mvp) {
+  ++frame_;
+  const auto capacity = frontier_.header().chunk_capacity;
+
+  // More chunks than slots cannot be shown.
+  // Only the nearest ones will be drawn.
+  auto visible = visible_chunks(mvp);
+  if (visible.size() > slot_count_) visible.resize(slot_count_);
+
+  draws_.clear();
+  size_t uploads = 0;
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+  for (auto chunk : visible) {
+    auto it = residents_.find(chunk);
+    if (it != end(residents_)) {
+      // Move the chunk to the front of the LRU list.
+      it->second->last_used = frame_;
+      lru_.splice(begin(lru_), lru_, it->second);
+    } else {
+      if (uploads == upload_budget) continue;
+      size_t slot;
+      if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+      } else {
+        // Evict the least recently used chunk
+        // if it is not needed for the current frame.
+        if (lru_.back().last_used == frame_) continue;
+        slot = lru_.back().slot;
+        residents_.erase(lru_.back().chunk);
+        lru_.pop_back();
+      }
+      const auto& c = frontier_.chunk(chunk);
+      glBufferSubData(GL_ARRAY_BUFFER, slot * capacity * sizeof(glm::vec3),
+                      c.count * sizeof(glm::vec3), frontier_.vertices(chunk));
+      lru_.push_front({chunk, slot, frame_});
+      it = residents_.emplace(chunk, begin(lru_)).first;
+      ++uploads;
+    }
+    draws_.push_back({it->second->slot * capacity,
+                      frontier_.chunk(chunk).count});
+  }
+
+  // Hand the chunks of the predicted view that are
+  // not resident yet to the prefetching thread.
+  auto predicted = visible_chunks(predicted_mvp);
+  if (predicted.size() > slot_count_) predicted.resize(slot_count_);
+  predicted.erase(remove_if(begin(predicted), end(predicted),
+                            [&](size_t c) { return residents_.count(c); }),
+                  end(predicted));
+  // Also prefetch currently visible chunks
+  // which did not fit into the upload budget.
+  for (auto chunk : visible)
+    if (!residents_.count(chunk)) predicted.push_back(chunk);
+  {
+    lock_guard lock{mutex_};
+    prefetch_queue_ = move(predicted);
+  }
+  condition_.notify_one();
+}
+
+void chunk_streamer::render() const {
+  glBindVertexArray(vertex_array_);
+  for (auto [first, count] : draws_) glDrawArrays(GL_POINTS, first, count);
+}
+
+void chunk_streamer::prefetch_loop() {
+  // Remember a bounded history of chunks which have already been read
+  // to not touch their pages again for every new prediction.
+  // Older entries are forgotten because the OS may have evicted them.
+  vector<bool> prefetched(frontier_.chunk_count(), false);
+  deque<size_t> history{};
+  while (true) {
+    vector<size_t> queue{};
+    {
+      unique_lock lock{mutex_};
+      condition_.wait(lock,
+                      [this] { return done_ || !prefetch_queue_.empty(); });
+      if (done_) return;
+      swap(queue, prefetch_queue_);
+    }
+    for (auto chunk : queue) {
+      if (done_) return;
+      if (prefetched[chunk]) continue;
+      frontier_.prefetch(chunk);
+      prefetched[chunk] = true;
+      history.push_back(chunk);
+      if (history.size() > 2 * slot_count_) {
+        prefetched[history.front()] = false;
+        history.pop_front();
+      }
+      // Newer predictions make the rest of the queue obsolete.
+      lock_guard lock{mutex_};
+      if (!prefetch_queue_.empty()) break;
+    }
+  }
+}
+
+}  // namespace vipo
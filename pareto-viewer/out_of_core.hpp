@@ -0,0 +1,142 @@
+#pragma once
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+//
+#include <glbinding/gl/gl.h>
+//
+#include <glm/glm.hpp>
+//
+#include "mapped_file.hpp"
+#include "memory_stats.hpp"
+
+namespace vipo {
+
+// Chunked Frontier File Layout
+// A header is followed by the chunk table and the vertex data.
+// Vertices are sorted along a Morton curve inside large blocks
+// such that every chunk covers a small and compact region of space.
+// Only vertices are stored. Edges are not supported out-of-core.
+struct chunked_frontier_header {
+  static constexpr char magic_string[8] = "VIPOCHK";
+  char magic[8];
+  uint32_t version;
+  uint32_t chunk_capacity;
+  uint64_t vertex_count;
+  uint64_t chunk_count;
+  uint64_t data_offset;
+  glm::vec3 aabb_min;
+  glm::vec3 aabb_max;
+};
+
+struct chunk_info {
+  // Byte offset of the first vertex relative to the beginning of the file.
+  uint64_t offset;
+  uint32_t count;
+  uint32_t reserved;
+  glm::vec3 aabb_min;
+  glm::vec3 aabb_max;
+};
+
+// Check if the given file starts with the chunked frontier magic string.
+bool is_chunked_frontier(const std::string& path);
+
+// Convert a Pareto frontier text file into the chunked layout.
+// The input is read twice. The first pass computes bounds and
+// the second one sorts blocks of 'block_size' vertices spatially.
+// Hence, memory usage is bounded by the block size and not by the input.
+// Throws 'std::runtime_error' with the line number for malformed lines.
+void write_chunked_frontier(const std::string& input,
+                            const std::string& output,
+                            uint32_t chunk_capacity = 1 << 16,
+                            size_t block_size = 1 << 24);
+
+// Read-only memory mapping of a chunked frontier file.
+// Only pages of chunks which are actually accessed are loaded by the OS.
+class chunked_frontier {
+ public:
+  explicit chunked_frontier(const std::string& path);
+
+  const chunked_frontier_header& header() const noexcept { return *header_; }
+  size_t chunk_count() const noexcept { return header_->chunk_count; }
+  const chunk_info& chunk(size_t i) const noexcept { return chunks_[i]; }
+  const glm::vec3* vertices(size_t i) const noexcept {
+    return reinterpret_cast<const glm::vec3*>(file_.data() +
+                                              chunks_[i].offset);
+  }
+
+  // Advise the OS to read the chunk and fault its pages in
+  // such that a later upload will not block on disk access.
+  void prefetch(size_t i) const noexcept;
+
+ private:
+  mapped_file file_;
+  const chunked_frontier_header* header_ = nullptr;
+  const chunk_info* chunks_ = nullptr;
+};
+
+// Streams the visible chunks of a chunked frontier
+// into a fixed-size pool of GPU buffer slots with LRU eviction.
+// Chunks that will become visible are read on a background thread.
+class chunk_streamer {
+ public:
+  chunk_streamer(const chunked_frontier& frontier, size_t slot_count);
+  ~chunk_streamer();
+  chunk_streamer(const chunk_streamer&) = delete;
+  chunk_streamer& operator=(const chunk_streamer&) = delete;
+
+  // Create the GPU buffer pool. Needs a current OpenGL context.
+  void init(gl::GLint vpos_location);
+  // Delete the GPU buffer pool. Needs a current OpenGL context.
+  void free();
+
+  // Determine the visible chunks for the current transformation,
+  // upload at most 'upload_budget' missing chunks,
+  // and schedule chunks visible by the predicted transformation
+  // for prefetching from disk.
+  void update(const glm::mat4& mvp, const glm::mat4& predicted_mvp);
+  // Draw all resident visible chunks as points.
+  void render() const;
+
+  size_t upload_budget = 8;
+
+ private:
+  // Chunks intersecting the view frustum sorted from near to far.
+  std::vector<size_t> visible_chunks(const glm::mat4& mvp) const;
+  void prefetch_loop();
+
+  const chunked_frontier& frontier_;
+  size_t slot_count_;
+  uint64_t frame_ = 0;
+
+  gl::GLuint vertex_array_ = 0;
+  gl::GLuint vertex_buffer_ = 0;
+  memory_account buffer_memory_{memory_pool::gpu_chunks};
+
+  // LRU list of occupied slots. Most recently used chunks are in front.
+  struct resident {
+    size_t chunk;
+    size_t slot;
+    uint64_t last_used;
+  };
+  std::list<resident> lru_{};
+  std::unordered_map<size_t, std::list<resident>::iterator> residents_{};
+  std::vector<size_t> free_slots_{};
+  std::vector<std::pair<size_t, uint32_t>> draws_{};
+
+  // Background Prefetching
+  std::thread prefetcher_{};
+  std::mutex mutex_{};
+  std::condition_variable condition_{};
+  std::vector<size_t> prefetch_queue_{};
+  std::atomic<bool> done_ = false;
+};
+
+}  // namespace vipo
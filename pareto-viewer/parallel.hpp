@@ -0,0 +1,43 @@
+#pragma once
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+//
+#include "thread_pool.hpp"
+
+namespace vipo {
+
+// Split the index range [0, n) into one contiguous chunk per hardware thread
+// and call f(first, last, chunk) for every chunk in parallel on the shared
+// thread pool. The calling thread processes the first chunk and helps
+// with the others. Small ranges are processed on the calling thread.
+// The first exception thrown by f is rethrown after all chunks are done.
+template <typename function>
+void parallel_chunks(size_t n, function&& f, size_t min_chunk_size = 1 << 16) {
+  const size_t thread_count = std::max<size_t>(
+      1, std::min<size_t>(std::thread::hardware_concurrency(),
+                          n / min_chunk_size));
+  const size_t chunk_size = (n + thread_count - 1) / thread_count;
+  if (thread_count == 1) {
+    f(size_t{0}, n, size_t{0});
+    return;
+  }
+  task_group group{};
+  for (size_t i = 1; i < thread_count; ++i) {
+    const auto first = std::min(i * chunk_size, n);
+    const auto last = std::min(first + chunk_size, n);
+    group.run([&f, first, last, i] { f(first, last, i); });
+  }
+  f(size_t{0}, std::min(chunk_size, n), size_t{0});
+  group.wait();
+}
+
+// Number of chunks parallel_chunks will use for a range of size n.
+inline size_t parallel_chunk_count(size_t n, size_t min_chunk_size = 1 << 16) {
+  return std::max<size_t>(
+      1, std::min<size_t>(std::thread::hardware_concurrency(),
+                          n / min_chunk_size));
+}
+
+}  // namespace vipo
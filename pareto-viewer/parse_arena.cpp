@@ -0,0 +1,33 @@
+#include "parse_arena.hpp"
+// STL
+#include <algorithm>
+#include <new>
+
+using namespace std;
+
+namespace vipo {
+
+parse_arena::parse_arena(size_t size_hint)
+    : arena_{max<size_t>(size_hint, 1), &blocks_} {}
+
+void* parse_arena::block_resource::do_allocate(size_t bytes,
+                                               size_t alignment) {
+  const auto data = ::operator new(bytes, align_val_t{alignment});
+  count_allocation();
+  memory_.add(bytes);
+  return data;
+}
+
+void parse_arena::block_resource::do_deallocate(void* data,
+                                                size_t bytes,
+                                                size_t alignment) {
+  memory_.set(memory_.bytes() - bytes);
+  ::operator delete(data, bytes, align_val_t{alignment});
+}
+
+bool parse_arena::block_resource::do_is_equal(
+    const memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+}  // namespace vipo
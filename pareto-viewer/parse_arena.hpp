@@ -0,0 +1,40 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <memory_resource>
+//
+#include "memory_stats.hpp"
+
+namespace vipo {
+
+// Monotonic arena for the temporaries of one parse task like the edges
+// of a chunk before they are concatenated. Nothing is freed before the
+// arena is destroyed. The first block has the size of the hint, e.g. the
+// expected size of the temporaries, and is only allocated when needed.
+// So growing containers make a handful of allocations at most.
+// Blocks are counted by 'allocation_count' and accounted as parse buffers.
+// An arena must only be used by one thread at a time.
+class parse_arena {
+ public:
+  explicit parse_arena(size_t size_hint);
+  parse_arena(const parse_arena&) = delete;
+  parse_arena& operator=(const parse_arena&) = delete;
+
+  std::pmr::memory_resource* resource() noexcept { return &arena_; }
+
+ private:
+  class block_resource : public std::pmr::memory_resource {
+   private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* data, size_t bytes, size_t alignment) override;
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+
+    memory_account memory_{memory_pool::parse_buffers};
+  };
+
+  block_resource blocks_{};
+  std::pmr::monotonic_buffer_resource arena_;
+};
+
+}  // namespace vipo
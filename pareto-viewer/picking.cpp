@@ -0,0 +1,77 @@
+#include "picking.hpp"
+// STL
+#include <utility>
+#include <vector>
+//
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+template <typename vertex_at>
+size_t pick_nearest(size_t n,
+                    vertex_at&& vertex,
+                    const axis_scaling& scaling,
+                    const glm::mat4& mvp,
+                    const glm::vec2& pixel,
+                    const glm::vec2& screen,
+                    float max_distance) {
+  // Transform the pixel into normalized device coordinates
+  // to not transform every vertex into pixel coordinates.
+  const glm::vec2 ndc{2.0f * pixel.x / screen.x - 1.0f,
+                      1.0f - 2.0f * pixel.y / screen.y};
+  const glm::vec2 ndc_scale{0.5f * screen.x, 0.5f * screen.y};
+  const float max_squared_distance = max_distance * max_distance;
+
+  // Every chunk stores its nearest vertex with its squared pixel distance.
+  vector<pair<float, size_t>> nearest(parallel_chunk_count(n),
+                                      {max_squared_distance, no_vertex});
+  parallel_chunks(n, [&](size_t first, size_t last, size_t chunk) {
+    auto best = nearest[chunk];
+    for (size_t i = first; i < last; ++i) {
+      const auto clip = mvp * glm::vec4(scaling.apply(vertex(i)), 1.0f);
+      if (clip.w <= 0.0f) continue;
+      if (abs(clip.z) > clip.w) continue;
+      const auto d = (glm::vec2{clip.x, clip.y} / clip.w - ndc) * ndc_scale;
+      const auto squared_distance = dot(d, d);
+      if (squared_distance < best.first) best = {squared_distance, i};
+    }
+    nearest[chunk] = best;
+  });
+
+  auto best = nearest[0];
+  for (const auto& x : nearest)
+    if (x.first < best.first) best = x;
+  return best.second;
+}
+
+}  // namespace
+
+size_t pick_vertex(span<const glm::vec3> vertices,
+                   const axis_scaling& scaling,
+                   const glm::mat4& mvp,
+                   const glm::vec2& pixel,
+                   const glm::vec2& screen,
+                   float max_distance) {
+  return pick_nearest(
+      vertices.size(), [&](size_t i) { return vertices[i]; }, scaling, mvp,
+      pixel, screen, max_distance);
+}
+
+size_t pick_vertex(span<const glm::dvec3> objectives,
+                   const objective_transform& transform,
+                   const axis_scaling& scaling,
+                   const glm::mat4& mvp,
+                   const glm::vec2& pixel,
+                   const glm::vec2& screen,
+                   float max_distance) {
+  return pick_nearest(
+      objectives.size(),
+      [&](size_t i) { return transform.to_render(objectives[i]); }, scaling,
+      mvp, pixel, screen, max_distance);
+}
+
+}  // namespace vipo
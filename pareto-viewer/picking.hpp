@@ -0,0 +1,38 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <limits>
+#include <span>
+//
+#include <glm/glm.hpp>
+//
+#include "axis_scaling.hpp"
+#include "objective_space.hpp"
+
+namespace vipo {
+
+constexpr size_t no_vertex = std::numeric_limits<size_t>::max();
+
+// Find the vertex whose projection is nearest to the given pixel
+// with origin in the upper left corner of the screen.
+// Vertices are transformed by the axis scaling as in the vertex shader.
+// Only vertices inside the view volume and closer than
+// 'max_distance' pixels are considered. Returns 'no_vertex' otherwise.
+// The vertices are scanned in parallel chunks.
+size_t pick_vertex(std::span<const glm::vec3> vertices,
+                   const axis_scaling& scaling,
+                   const glm::mat4& mvp,
+                   const glm::vec2& pixel,
+                   const glm::vec2& screen,
+                   float max_distance);
+// Same for vertices that only exist on the GPU. They are mapped
+// from their objectives by the given transform while scanning.
+size_t pick_vertex(std::span<const glm::dvec3> objectives,
+                   const objective_transform& transform,
+                   const axis_scaling& scaling,
+                   const glm::mat4& mvp,
+                   const glm::vec2& pixel,
+                   const glm::vec2& screen,
+                   float max_distance);
+
+}  // namespace vipo
@@ -0,0 +1,456 @@
+#include "ply_file.hpp"
+// STL
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+//
+#include "strided_gather.hpp"
+#include "text_cursor.hpp"
+#include "text_frontier.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+enum class ply_format { ascii, binary_little_endian, binary_big_endian };
+
+struct ply_property {
+  string name;
+  scalar_type type;
+  // List properties store their size in front of the values.
+  bool list = false;
+  scalar_type count_type = scalar_type::uint8;
+  // Byte offset inside of a binary element without list properties.
+  size_t offset = 0;
+};
+
+struct ply_element {
+  string name;
+  size_t count = 0;
+  vector<ply_property> properties{};
+  // Byte size of a binary row or zero if it contains list properties.
+  size_t stride = 0;
+  // Beginning of the element's rows in a binary file.
+  const char* data = nullptr;
+
+  size_t find(string_view property) const noexcept {
+    for (size_t i = 0; i < properties.size(); ++i)
+      if (properties[i].name == property) return i;
+    return properties.size();
+  }
+};
+
+scalar_type parse_type(string_view name, size_t line) {
+  constexpr pair<string_view, scalar_type> types[] = {
+      {"char", scalar_type::int8},       {"int8", scalar_type::int8},
+      {"uchar", scalar_type::uint8},     {"uint8", scalar_type::uint8},
+      {"short", scalar_type::int16},     {"int16", scalar_type::int16},
+      {"ushort", scalar_type::uint16},   {"uint16", scalar_type::uint16},
+      {"int", scalar_type::int32},       {"int32", scalar_type::int32},
+      {"uint", scalar_type::uint32},     {"uint32", scalar_type::uint32},
+      {"float", scalar_type::float32},   {"float32", scalar_type::float32},
+      {"double", scalar_type::float64},  {"float64", scalar_type::float64}};
+  for (const auto& [n, type] : types)
+    if (n == name) return type;
+  throw runtime_error("Failed to parse PLY header line " + to_string(line) +
+                      ". Type '" + string(name) + "' is unknown.");
+}
+
+// Parse the header and return the position of the first data byte.
+const char* parse_header(const char* data,
+                         size_t size,
+                         ply_format& format,
+                         vector<ply_element>& elements) {
+  text_cursor cursor{data, data + size};
+  if (cursor.token() != "ply" || !cursor.at_line_end())
+    throw runtime_error("Failed to parse PLY file. Magic string is missing.");
+  cursor.next_line();
+  bool has_format = false;
+  while (!cursor.done()) {
+    const auto keyword = cursor.token();
+    if (keyword == "end_header") {
+      cursor.next_line();
+      if (!has_format)
+        throw runtime_error("Failed to parse PLY header. Format is missing.");
+      return cursor.position();
+    }
+    if (keyword == "format") {
+      const auto name = cursor.token();
+      if (name == "ascii")
+        format = ply_format::ascii;
+      else if (name == "binary_little_endian")
+        format = ply_format::binary_little_endian;
+      else if (name == "binary_big_endian")
+        format = ply_format::binary_big_endian;
+      else
+        throw runtime_error("Failed to parse PLY header. Format '" +
+                            string(name) + "' is unknown.");
+      has_format = true;
+    } else if (keyword == "element") {
+      ply_element element{};
+      element.name = cursor.token();
+      element.count = cursor.number<size_t>();
+      elements.push_back(move(element));
+    } else if (keyword == "property") {
+      if (elements.empty())
+        throw runtime_error("Failed to parse PLY header line " +
+                            to_string(cursor.line()) +
+                            ". Property without element.");
+      ply_property property{};
+      auto type = cursor.token();
+      if (type == "list") {
+        property.list = true;
+        property.count_type = parse_type(cursor.token(), cursor.line());
+        type = cursor.token();
+      }
+      property.type = parse_type(type, cursor.line());
+      property.name = cursor.token();
+      elements.back().properties.push_back(move(property));
+    } else if (keyword != "comment" && keyword != "obj_info" &&
+               !keyword.empty()) {
+      throw runtime_error("Failed to parse PLY header line " +
+                          to_string(cursor.line()) + ". Keyword '" +
+                          string(keyword) + "' is unknown.");
+    }
+    cursor.next_line();
+  }
+  throw runtime_error("Failed to parse PLY file. Header is not terminated.");
+}
+
+// Binary reading
+
+// Assign the rows of all elements to the data range. Rows without list
+// properties have a fixed size. Otherwise, the rows have to be walked.
+void layout_binary(vector<ply_element>& elements,
+                   const char* data,
+                   const char* end,
+                   bool swap) {
+  const auto truncated = [] {
+    return runtime_error("Failed to parse PLY file. Data is truncated.");
+  };
+  for (auto& element : elements) {
+    element.data = data;
+    size_t stride = 0;
+    bool fixed = true;
+    for (auto& property : element.properties) {
+      property.offset = stride;
+      fixed = fixed && !property.list;
+      stride += size_of(property.type);
+    }
+    if (fixed) {
+      element.stride = stride;
+      if (element.count > size_t(end - data) / max<size_t>(stride, 1))
+        throw truncated();
+      data += element.count * stride;
+      continue;
+    }
+    for (size_t i = 0; i < element.count; ++i) {
+      for (const auto& property : element.properties) {
+        if (!property.list) {
+          data += size_of(property.type);
+          continue;
+        }
+        if (data > end || size_t(end - data) < size_of(property.count_type))
+          throw truncated();
+        const auto n = read_scalar<uint64_t>(property.count_type, data, swap);
+        data += size_of(property.count_type);
+        if (n > size_t(end - data) / size_of(property.type)) throw truncated();
+        data += n * size_of(property.type);
+      }
+      if (data > end) throw truncated();
+    }
+  }
+}
+
+// Call f(row, offsets) for every row of an element with list properties
+// where offsets contains the byte offset of every property in the row.
+template <typename function>
+void for_each_binary_row(const ply_element& element, bool swap, function f) {
+  vector<size_t> offsets(element.properties.size());
+  auto row = element.data;
+  for (size_t i = 0; i < element.count; ++i) {
+    size_t offset = 0;
+    for (size_t p = 0; p < element.properties.size(); ++p) {
+      const auto& property = element.properties[p];
+      offsets[p] = offset;
+      if (property.list)
+        offset += size_of(property.count_type) +
+                  read_scalar<uint64_t>(property.count_type, row + offset,
+                                        swap) *
+                      size_of(property.type);
+      else
+        offset += size_of(property.type);
+    }
+    f(row, offsets);
+    row += offset;
+  }
+}
+
+void read_binary_vertices(const ply_element& element,
+                          const array<size_t, 3>& columns,
+                          bool swap,
+                          large_vector<glm::dvec3>& objectives) {
+  objectives.resize(element.count);
+  if (element.count == 0) return;
+  if (element.stride != 0) {
+    for (int k = 0; k < 3; ++k) {
+      const auto& property = element.properties[columns[k]];
+      gather(property.type, element.data + property.offset, element.stride,
+             element.count, swap, &objectives[0][k], 3);
+    }
+    return;
+  }
+  size_t i = 0;
+  for_each_binary_row(element, swap, [&](const char* row, const auto& offsets) {
+    for (int k = 0; k < 3; ++k)
+      objectives[i][k] = read_scalar<double>(
+          element.properties[columns[k]].type, row + offsets[columns[k]], swap);
+    ++i;
+  });
+}
+
+void read_binary_edges(const ply_element& element,
+                       size_t first,
+                       size_t second,
+                       bool swap,
+                       large_vector<edge>& edges) {
+  const auto offset = edges.size();
+  edges.resize(offset + element.count);
+  if (element.count == 0) return;
+  static_assert(sizeof(edge) == 2 * sizeof(uint64_t));
+  const auto out = reinterpret_cast<uint64_t*>(&edges[offset]);
+  if (element.stride != 0) {
+    const auto& a = element.properties[first];
+    const auto& b = element.properties[second];
+    gather(a.type, element.data + a.offset, element.stride, element.count,
+           swap, out, 2);
+    gather(b.type, element.data + b.offset, element.stride, element.count,
+           swap, out + 1, 2);
+    return;
+  }
+  size_t i = 0;
+  for_each_binary_row(element, swap, [&](const char* row, const auto& offsets) {
+    edges[offset + i].first = read_scalar<uint64_t>(
+        element.properties[first].type, row + offsets[first], swap);
+    edges[offset + i].second = read_scalar<uint64_t>(
+        element.properties[second].type, row + offsets[second], swap);
+    ++i;
+  });
+}
+
+void read_binary_faces(const ply_element& element,
+                       size_t indices,
+                       bool swap,
+                       large_vector<edge>& edges) {
+  const auto& property = element.properties[indices];
+  vector<uint64_t> polygon{};
+  for_each_binary_row(element, swap, [&](const char* row, const auto& offsets) {
+    auto p = row + offsets[indices];
+    const auto n = read_scalar<uint64_t>(property.count_type, p, swap);
+    p += size_of(property.count_type);
+    polygon.resize(n);
+    if (n != 0)
+      gather(property.type, p, size_of(property.type), n, swap,
+             polygon.data(), 1);
+    for (size_t j = 0; j < n; ++j)
+      edges.emplace_back(polygon[j], polygon[(j + 1) % n]);
+  });
+}
+
+// ASCII reading
+
+void skip_blank_lines(text_cursor& cursor) {
+  while (!cursor.done() && cursor.at_line_end()) cursor.next_line();
+}
+
+void end_row(text_cursor& cursor) {
+  if (!cursor.at_line_end())
+    cursor.fail(cursor.token(), "is an unexpected value");
+  cursor.next_line();
+}
+
+// Read the values of one property and call f(j, n, cursor) for its
+// n values with the cursor positioned in front of the j-th value.
+template <typename function>
+void read_ascii_property(text_cursor& cursor,
+                         const ply_property& property,
+                         function f) {
+  if (!property.list) {
+    f(size_t{0}, size_t{1}, cursor);
+    return;
+  }
+  const auto n = cursor.number<size_t>();
+  for (size_t j = 0; j < n; ++j) f(j, n, cursor);
+}
+
+void read_ascii(text_cursor& cursor,
+                const vector<ply_element>& elements,
+                const array<size_t, 3>& columns,
+                large_vector<glm::dvec3>& objectives,
+                large_vector<edge>& edges) {
+  // The header gives the number of rows. So the arrays are allocated once
+  // unless faces have more than three edges.
+  size_t vertex_count = 0;
+  size_t edge_count = 0;
+  for (const auto& element : elements) {
+    if (element.name == "vertex") vertex_count += element.count;
+    if (element.name == "edge") edge_count += element.count;
+    if (element.name == "face") edge_count += 3 * element.count;
+  }
+  objectives.reserve(vertex_count);
+  edges.reserve(edge_count);
+
+  vector<uint64_t> polygon{};
+  for (const auto& element : elements) {
+    const auto& properties = element.properties;
+    if (element.name == "vertex" &&
+        none_of(properties.begin(), properties.end(),
+                [](auto& x) { return x.list; })) {
+      // Find the end of the rows which is much cheaper than parsing them.
+      // Then, the rows are parsed in parallel by the fast text path.
+      text_cursor end = cursor;
+      for (size_t i = 0; i < element.count; end.next_line()) {
+        if (end.done())
+          throw runtime_error("Failed to parse PLY file. Data is truncated.");
+        i += !end.at_line_end();
+      }
+      parse_text_rows(cursor.position(), end.position(), cursor.line(),
+                      properties.size(), columns, objectives);
+      cursor = end;
+      continue;
+    }
+    const auto first = element.find("vertex1");
+    const auto second = element.find("vertex2");
+    auto indices = element.find("vertex_indices");
+    if (indices == element.properties.size())
+      indices = element.find("vertex_index");
+    for (size_t i = 0; i < element.count; ++i) {
+      skip_blank_lines(cursor);
+      if (cursor.done())
+        throw runtime_error("Failed to parse PLY file. Data is truncated.");
+      glm::dvec3 v{};
+      edge e{};
+      for (size_t p = 0; p < element.properties.size(); ++p) {
+        read_ascii_property(
+            cursor, element.properties[p],
+            [&](size_t j, size_t n, text_cursor& c) {
+              if (element.name == "vertex") {
+                for (int k = 0; k < 3; ++k) {
+                  if (p != columns[k]) continue;
+                  v[k] = c.number<double>();
+                  return;
+                }
+              } else if (element.name == "edge") {
+                if (p == first) return void(e.first = c.number<uint64_t>());
+                if (p == second) return void(e.second = c.number<uint64_t>());
+              } else if (element.name == "face" && p == indices) {
+                if (j == 0) polygon.clear();
+                polygon.push_back(c.number<uint64_t>());
+                if (j + 1 == n)
+                  for (size_t q = 0; q < n; ++q)
+                    edges.emplace_back(polygon[q], polygon[(q + 1) % n]);
+                return;
+              }
+              c.token();
+            });
+      }
+      end_row(cursor);
+      if (element.name == "vertex") objectives.push_back(v);
+      if (element.name == "edge" && first != element.properties.size() &&
+          second != element.properties.size())
+        edges.push_back(e);
+    }
+  }
+}
+
+}  // namespace
+
+void load_ply(const string& path,
+              const vector<string>& columns,
+              frontier_data& frontier) {
+  auto file = make_shared<const mapped_file>(path);
+  const auto end = file->data() + file->size();
+  ply_format format;
+  vector<ply_element> elements{};
+  const auto data = parse_header(file->data(), file->size(), format, elements);
+
+  const auto vertex = find_if(elements.begin(), elements.end(),
+                              [](auto& e) { return e.name == "vertex"; });
+  if (vertex == elements.end())
+    throw runtime_error("Failed to load file '" + path +
+                        "'. It does not contain a vertex element.");
+  if (!columns.empty() && columns.size() != 3)
+    throw runtime_error("Exactly three vertex properties have to be selected.");
+  array<size_t, 3> selected{};
+  for (int k = 0; k < 3; ++k) {
+    const auto name = columns.empty() ? string(1, char('x' + k)) : columns[k];
+    selected[k] = vertex->find(name);
+    if (selected[k] == vertex->properties.size() ||
+        vertex->properties[selected[k]].list)
+      throw runtime_error("Failed to load file '" + path +
+                          "'. Vertex property '" + name + "' does not exist.");
+  }
+
+  if (format == ply_format::ascii) {
+    // Line numbers in error messages count the header lines too.
+    text_cursor cursor{data, end, size_t(count(file->data(), data, '\n')) + 1};
+    read_ascii(cursor, elements, selected, frontier.objectives,
+               frontier.edges);
+  } else {
+    const auto swap = (format == ply_format::binary_little_endian) !=
+                      (endian::native == endian::little);
+    layout_binary(elements, data, end, swap);
+    for (const auto& element : elements) {
+      if (&element == &*vertex) {
+        // Vertices consisting of exactly three floats in native byte order
+        // can be handed to OpenGL directly from the mapping.
+        static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+        const auto& p = element.properties;
+        const bool direct =
+            !swap && element.stride == sizeof(glm::vec3) &&
+            selected == array<size_t, 3>{0, 1, 2} &&
+            all_of(p.begin(), p.end(),
+                   [](auto& x) { return x.type == scalar_type::float32; }) &&
+            reinterpret_cast<uintptr_t>(element.data) % alignof(glm::vec3) ==
+                0;
+        if (direct) {
+          frontier.mapped_vertices = {
+              reinterpret_cast<const glm::vec3*>(element.data), element.count};
+          frontier.mapping = file;
+        } else {
+          read_binary_vertices(element, selected, swap, frontier.objectives);
+        }
+      } else if (element.name == "edge") {
+        const auto first = element.find("vertex1");
+        const auto second = element.find("vertex2");
+        if (first == element.properties.size() ||
+            second == element.properties.size() ||
+            element.properties[first].list || element.properties[second].list)
+          continue;
+        read_binary_edges(element, first, second, swap, frontier.edges);
+      } else if (element.name == "face") {
+        auto indices = element.find("vertex_indices");
+        if (indices == element.properties.size())
+          indices = element.find("vertex_index");
+        if (indices == element.properties.size() ||
+            !element.properties[indices].list)
+          continue;
+        read_binary_faces(element, indices, swap, frontier.edges);
+      }
+    }
+  }
+
+  // Neighboring polygons share their boundary edges.
+  if (any_of(elements.begin(), elements.end(),
+             [](auto& e) { return e.name == "face"; }))
+    remove_duplicate_edges(frontier.edges);
+
+  check_edges(path, frontier.size(), frontier.edges);
+}
+
+}  // namespace vipo
@@ -0,0 +1,23 @@
+#pragma once
+// STL
+#include <string>
+#include <vector>
+//
+#include "frontier_file.hpp"
+
+namespace vipo {
+
+// Load a PLY file in ASCII or binary format. The objectives are given by
+// three properties of the 'vertex' element which are 'x', 'y', and 'z'
+// if no other names are given. Edges are taken from the 'vertex1' and
+// 'vertex2' properties of an 'edge' element and from the boundaries
+// of the polygons in a 'face' element. Other elements are skipped.
+// Binary vertex elements consisting only of the three float properties
+// in native byte order are used without any copy. All other binary
+// layouts are read by strided gathers. Throws 'std::runtime_error'
+// for malformed or truncated files.
+void load_ply(const std::string& path,
+              const std::vector<std::string>& columns,
+              frontier_data& frontier);
+
+}  // namespace vipo
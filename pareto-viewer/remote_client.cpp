@@ -0,0 +1,153 @@
+#include "remote_client.hpp"
+// STL
+#include <stdexcept>
+#include <vector>
+//
+// glbinding handles the OpenGL
+// inclusion and extension loading.
+#include <glbinding/gl/gl.h>
+#include <glbinding/glbinding.h>
+//
+// Use GLFW as platform-independent library to create a window.
+// Because of glbinding, we do not want GLFW to include OpenGL.
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+//
+#include <glm/glm.hpp>
+//
+#include "memory_stats.hpp"
+#include "remote_rendering.hpp"
+
+using namespace std;
+using namespace gl;
+
+namespace vipo {
+
+namespace {
+
+// Input collected by the callbacks between two iterations.
+struct client_input {
+  float scroll = 0.0f;
+  vector<int> keys{};
+};
+
+}  // namespace
+
+void run_remote_client(const string& path, const viewer_options& options) {
+  auto server = local_socket::connect(path);
+  const auto send = [&server](const remote_event& event) {
+    send_message(server, remote_message::event,
+                 {reinterpret_cast<const char*>(&event), sizeof(event)});
+  };
+
+  glfwSetErrorCallback([](int error, const char* description) {
+    throw runtime_error("GLFW Error " + to_string(error) + ": " + description);
+  });
+  glfwInit();
+  struct guard {
+    ~guard() { glfwTerminate(); }
+  } g{};
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  const auto window = glfwCreateWindow(options.width, options.height,
+                                       options.title.c_str(), nullptr, nullptr);
+  glfwMakeContextCurrent(window);
+  glbinding::initialize(glfwGetProcAddress);
+
+  client_input input{};
+  glfwSetWindowUserPointer(window, &input);
+  glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int scancode,
+                                int action, int mods) {
+    if (action != GLFW_PRESS) return;
+    if (key == GLFW_KEY_ESCAPE) glfwSetWindowShouldClose(window, GLFW_TRUE);
+    static_cast<client_input*>(glfwGetWindowUserPointer(window))
+        ->keys.push_back(key);
+  });
+  glfwSetScrollCallback(window, [](GLFWwindow* window, double x, double y) {
+    static_cast<client_input*>(glfwGetWindowUserPointer(window))->scroll +=
+        float(y);
+  });
+
+  // Frames are copied into a texture and blitted onto the screen.
+  // So neither shaders nor vertex data are needed.
+  GLuint texture, framebuffer;
+  memory_account texture_memory{memory_pool::gpu_frames};
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glGenFramebuffers(1, &framebuffer);
+
+  int width = 0, height = 0;
+  glm::vec2 mouse_pos{};
+  frame_decoder decoder{};
+  vector<char> message{};
+  while (!glfwWindowShouldClose(window)) {
+    glfwWaitEventsTimeout(1.0 / 120);
+
+    // Frames are rendered by the server in the size of the framebuffer.
+    int w, h;
+    glfwGetFramebufferSize(window, &w, &h);
+    if (w != width || h != height) {
+      width = w;
+      height = h;
+      send({remote_event_type::resize, float(width), float(height)});
+    }
+    const auto old_mouse_pos = mouse_pos;
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    mouse_pos = glm::vec2{xpos, ypos};
+    const auto move = mouse_pos - old_mouse_pos;
+    if (move != glm::vec2{0.0f}) {
+      if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+        send({remote_event_type::orbit, move.x, move.y});
+      if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS)
+        send({remote_event_type::pan, move.x, move.y});
+    }
+    if (input.scroll != 0.0f)
+      send({remote_event_type::zoom, 0.0f, input.scroll});
+    input.scroll = 0.0f;
+    for (const auto key : input.keys)
+      send({remote_event_type::key, 0.0f, 0.0f, key});
+    input.keys.clear();
+
+    // Every frame is a difference to the previous one.
+    // So all of them are decoded but only the newest is shown.
+    bool received = false;
+    while (server.readable(0)) {
+      if (receive_message(server, message) != remote_message::frame)
+        throw runtime_error("Failed to read frame from render server.");
+      decoder.decode(message);
+      received = true;
+    }
+    if (!received) continue;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, decoder.width(), decoder.height(),
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, decoder.pixels().data());
+    texture_memory.set(decoder.pixels().size_bytes());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, texture, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // Rows are sent from the top. So the image is flipped.
+    glBlitFramebuffer(0, 0, decoder.width(), decoder.height(), 0, height,
+                      decoder.width(), height - decoder.height(),
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glfwSwapBuffers(window);
+  }
+
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteTextures(1, &texture);
+  texture_memory.set(0);
+  glfwDestroyWindow(window);
+  try {
+    send({remote_event_type::close});
+  } catch (exception&) {
+    // The server may already be gone.
+  }
+}
+
+}  // namespace vipo
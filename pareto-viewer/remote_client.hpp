@@ -0,0 +1,16 @@
+#pragma once
+// STL
+#include <string>
+//
+#include "viewer.hpp"
+
+namespace vipo {
+
+// Thin client of a render server started by 'viewer::serve'.
+// It shows the received frames in a window and sends its input back.
+// No frontier data is needed. Returns when the window is closed.
+// Throws 'std::runtime_error' if the server cannot be reached.
+void run_remote_client(const std::string& path,
+                       const viewer_options& options = {});
+
+}  // namespace vipo
@@ -0,0 +1,264 @@
+#include "remote_rendering.hpp"
+// STL
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+// POSIX
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+//
+#include <zstd.h>
+//
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+struct message_header {
+  remote_message type;
+  uint32_t reserved;
+  uint64_t size;
+};
+
+struct frame_header {
+  uint32_t width;
+  uint32_t height;
+  uint32_t band_rows;
+  uint32_t band_count;
+};
+
+sockaddr_un socket_address(const string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    throw runtime_error("Failed to use socket path '" + path +
+                        "' because it is too long.");
+  memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+// Range of pixels in the given band of rows.
+pair<size_t, size_t> band_range(size_t band, int width, int height) {
+  const auto first = band * frame_encoder::band_rows * width;
+  const auto last =
+      min((band + 1) * frame_encoder::band_rows, size_t(height)) * width;
+  return {first, last};
+}
+
+}  // namespace
+
+local_socket::~local_socket() {
+  if (fd_ != -1) close(fd_);
+}
+
+local_socket::local_socket(local_socket&& other) noexcept
+    : fd_{exchange(other.fd_, -1)} {}
+
+local_socket& local_socket::operator=(local_socket&& other) noexcept {
+  swap(fd_, other.fd_);
+  return *this;
+}
+
+local_socket local_socket::accept(const string& path) {
+  const auto address = socket_address(path);
+  const local_socket server{socket(AF_UNIX, SOCK_STREAM, 0)};
+  if (server.fd_ == -1)
+    throw runtime_error("Failed to create socket '" + path + "'.");
+  // A socket file of a previous server would block the address.
+  // Other files are never removed, e.g. after a mistyped path.
+  struct stat status;
+  if (lstat(path.c_str(), &status) == 0) {
+    if (!S_ISSOCK(status.st_mode))
+      throw runtime_error("Failed to listen at socket '" + path +
+                          "'. A file that is not a socket exists there.");
+    unlink(path.c_str());
+  }
+  if (bind(server.fd_, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) == -1 ||
+      listen(server.fd_, 1) == -1)
+    throw runtime_error("Failed to listen at socket '" + path + "'.");
+  local_socket client{::accept(server.fd_, nullptr, nullptr)};
+  unlink(path.c_str());
+  if (client.fd_ == -1)
+    throw runtime_error("Failed to accept client at socket '" + path + "'.");
+  return client;
+}
+
+local_socket local_socket::connect(const string& path) {
+  const auto address = socket_address(path);
+  local_socket client{socket(AF_UNIX, SOCK_STREAM, 0)};
+  if (client.fd_ == -1 ||
+      ::connect(client.fd_, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) == -1)
+    throw runtime_error("Failed to connect to socket '" + path + "'.");
+  return client;
+}
+
+bool local_socket::readable(int timeout) const {
+  pollfd p{fd_, POLLIN, 0};
+  return poll(&p, 1, timeout) > 0;
+}
+
+void local_socket::send(const void* data, size_t size) {
+  auto bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    // A closed peer must not terminate the process by SIGPIPE.
+    const auto n = ::send(fd_, bytes, size, MSG_NOSIGNAL);
+    if (n <= 0) throw runtime_error("Failed to send data over socket.");
+    bytes += n;
+    size -= n;
+  }
+}
+
+void local_socket::receive(void* data, size_t size) {
+  auto bytes = static_cast<char*>(data);
+  while (size > 0) {
+    const auto n = recv(fd_, bytes, size, 0);
+    if (n <= 0)
+      throw runtime_error("Failed to receive data because socket is closed.");
+    bytes += n;
+    size -= n;
+  }
+}
+
+void send_message(local_socket& socket,
+                  remote_message type,
+                  span<const char> payload) {
+  const message_header header{type, 0, payload.size()};
+  socket.send(&header, sizeof(header));
+  socket.send(payload.data(), payload.size());
+}
+
+remote_message receive_message(local_socket& socket, vector<char>& payload) {
+  message_header header;
+  socket.receive(&header, sizeof(header));
+  if (header.size > max_message_size)
+    throw runtime_error("Failed to receive message because it is too large.");
+  payload.resize(header.size);
+  socket.receive(payload.data(), payload.size());
+  return header.type;
+}
+
+span<const char> frame_encoder::encode(span<const uint32_t> pixels,
+                                       int width,
+                                       int height) {
+  if (width != width_ || height != height_) {
+    width_ = width;
+    height_ = height;
+    previous_.assign(size_t(width) * height, 0);
+  }
+  const size_t band_count = (height + band_rows - 1) / band_rows;
+  bands_.resize(band_count);
+
+  parallel_chunks(
+      band_count,
+      [&](size_t first, size_t last, size_t) {
+        const auto context = ZSTD_createCCtx();
+        if (!context)
+          throw runtime_error("Failed to initialize Zstandard compression.");
+        struct guard {
+          ZSTD_CCtx* context;
+          ~guard() { ZSTD_freeCCtx(context); }
+        } g{context};
+        vector<uint32_t> delta{};
+        for (auto b = first; b < last; ++b) {
+          const auto [begin, end] = band_range(b, width, height);
+          delta.resize(end - begin);
+          for (auto i = begin; i < end; ++i) {
+            delta[i - begin] = pixels[i] ^ previous_[i];
+            previous_[i] = pixels[i];
+          }
+          const auto bytes = delta.size() * sizeof(uint32_t);
+          auto& band = bands_[b];
+          band.resize(ZSTD_compressBound(bytes));
+          const auto size = ZSTD_compressCCtx(context, band.data(), band.size(),
+                                              delta.data(), bytes, level_);
+          if (ZSTD_isError(size))
+            throw runtime_error(string("Failed to compress frame: ") +
+                                ZSTD_getErrorName(size));
+          band.resize(size);
+        }
+      },
+      1);
+
+  // Layout: header, compressed size of every band, and the bands.
+  const frame_header header{uint32_t(width), uint32_t(height), band_rows,
+                            uint32_t(band_count)};
+  data_.resize(sizeof(header) + band_count * sizeof(uint64_t));
+  memcpy(data_.data(), &header, sizeof(header));
+  for (size_t b = 0; b < band_count; ++b) {
+    const uint64_t size = bands_[b].size();
+    memcpy(data_.data() + sizeof(header) + b * sizeof(uint64_t), &size,
+           sizeof(size));
+    data_.insert(end(data_), begin(bands_[b]), end(bands_[b]));
+  }
+  return data_;
+}
+
+void frame_decoder::decode(span<const char> data) {
+  frame_header header;
+  if (data.size() < sizeof(header))
+    throw runtime_error("Failed to decode frame because it is too short.");
+  memcpy(&header, data.data(), sizeof(header));
+  // The size is checked first. So the band count cannot overflow.
+  if (header.width > uint32_t(max_frame_extent) ||
+      header.height > uint32_t(max_frame_extent))
+    throw runtime_error("Failed to decode frame because it is too large.");
+  if (header.band_rows != frame_encoder::band_rows ||
+      header.band_count !=
+          (header.height + header.band_rows - 1) / header.band_rows ||
+      data.size() < sizeof(header) + header.band_count * sizeof(uint64_t))
+    throw runtime_error("Failed to decode frame because of invalid header.");
+  if (int(header.width) != width_ || int(header.height) != height_) {
+    width_ = header.width;
+    height_ = header.height;
+    pixels_.assign(size_t(width_) * height_, 0);
+  }
+
+  // Offsets of the bands are needed to decompress them in parallel.
+  vector<pair<size_t, size_t>> bands(header.band_count);
+  size_t offset = sizeof(header) + header.band_count * sizeof(uint64_t);
+  for (size_t b = 0; b < bands.size(); ++b) {
+    uint64_t size;
+    memcpy(&size, data.data() + sizeof(header) + b * sizeof(uint64_t),
+           sizeof(size));
+    if (size > data.size() - offset)
+      throw runtime_error("Failed to decode frame because it is truncated.");
+    bands[b] = {offset, size};
+    offset += size;
+  }
+
+  parallel_chunks(
+      bands.size(),
+      [&](size_t first, size_t last, size_t) {
+        const auto context = ZSTD_createDCtx();
+        if (!context)
+          throw runtime_error("Failed to initialize Zstandard decompression.");
+        struct guard {
+          ZSTD_DCtx* context;
+          ~guard() { ZSTD_freeDCtx(context); }
+        } g{context};
+        vector<uint32_t> delta{};
+        for (auto b = first; b < last; ++b) {
+          const auto [begin, end] = band_range(b, width_, height_);
+          delta.resize(end - begin);
+          const auto bytes = delta.size() * sizeof(uint32_t);
+          const auto [offset, compressed] = bands[b];
+          const auto size = ZSTD_decompressDCtx(
+              context, delta.data(), bytes, data.data() + offset, compressed);
+          if (ZSTD_isError(size) || size != bytes)
+            throw runtime_error("Failed to decompress frame.");
+          for (auto i = begin; i < end; ++i) pixels_[i] ^= delta[i - begin];
+        }
+      },
+      1);
+}
+
+}  // namespace vipo
@@ -0,0 +1,122 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vipo {
+
+// Connected stream socket in the local domain. The render server
+// runs next to the data and only frames and input events are sent.
+// Remote machines are reached by forwarding the socket, e.g. with SSH.
+class local_socket {
+ public:
+  local_socket() = default;
+  ~local_socket();
+  local_socket(local_socket&& other) noexcept;
+  local_socket& operator=(local_socket&& other) noexcept;
+
+  // Listen at the given path and wait for one client to connect.
+  // A socket file of a previous server is replaced. Throws
+  // 'std::runtime_error' if the socket cannot be created or another
+  // kind of file exists at the path.
+  static local_socket accept(const std::string& path);
+  // Throws 'std::runtime_error' if no server listens at the path.
+  static local_socket connect(const std::string& path);
+
+  // Wait at most the given time in milliseconds for incoming data.
+  bool readable(int timeout) const;
+  // Both throw 'std::runtime_error' if the connection has been closed.
+  void send(const void* data, size_t size);
+  void receive(void* data, size_t size);
+
+ private:
+  explicit local_socket(int fd) noexcept : fd_{fd} {}
+
+  int fd_ = -1;
+};
+
+enum class remote_message : uint32_t { frame = 1, event = 2 };
+
+// Largest width and height of remote frames. Peers must not be able
+// to make the other side allocate arbitrary amounts of memory.
+constexpr int max_frame_extent = 1 << 14;
+// Largest payload of a message which is enough for an incompressible
+// frame of the largest size.
+constexpr size_t max_message_size = size_t{1} << 31;
+
+// Send the payload behind a header with its type and size.
+void send_message(local_socket& socket,
+                  remote_message type,
+                  std::span<const char> payload);
+// Receive the next message and store its payload in the given buffer.
+// Throws 'std::runtime_error' if the payload is larger than the limit.
+remote_message receive_message(local_socket& socket,
+                               std::vector<char>& payload);
+
+// Input of the client that is applied to the camera of the server.
+// Movements are given in pixels of the client window.
+enum class remote_event_type : uint32_t {
+  resize,
+  orbit,
+  pan,
+  zoom,
+  key,
+  close
+};
+struct remote_event {
+  remote_event_type type;
+  float x = 0.0f;
+  float y = 0.0f;
+  // GLFW key code of pressed keys
+  int32_t key = 0;
+};
+
+// Frames are sent as difference to the previous frame. Unchanged pixels
+// become zeros which compress to almost nothing. The image is split into
+// bands of rows that are compressed independently with Zstandard
+// on the thread pool. So encoding scales with the number of cores.
+// Lossless compression keeps thin lines of the frontier sharp.
+class frame_encoder {
+ public:
+  static constexpr int band_rows = 32;
+
+  explicit frame_encoder(int level = 1) noexcept : level_{level} {}
+
+  // Encode packed RGBA pixels given row by row from the top.
+  // A change of the size starts again from a black frame.
+  // The returned data is valid until the next call.
+  std::span<const char> encode(std::span<const uint32_t> pixels,
+                               int width,
+                               int height);
+
+ private:
+  int level_;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint32_t> previous_{};
+  std::vector<std::vector<char>> bands_{};
+  std::vector<char> data_{};
+};
+
+class frame_decoder {
+ public:
+  // Apply the encoded difference to the current frame. Throws
+  // 'std::runtime_error' if the data is corrupted or the frame is larger
+  // than 'max_frame_extent' in any direction.
+  void decode(std::span<const char> data);
+
+  int width() const noexcept { return width_; }
+  int height() const noexcept { return height_; }
+  // Packed RGBA pixels row by row from the top.
+  std::span<const uint32_t> pixels() const noexcept { return pixels_; }
+
+ private:
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint32_t> pixels_{};
+};
+
+}  // namespace vipo
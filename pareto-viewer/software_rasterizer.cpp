@@ -0,0 +1,245 @@
+#include "software_rasterizer.hpp"
+// STL
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+//
+#include <glm/ext.hpp>
+//
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+constexpr size_t block_size = 256;
+
+// Colors are stored as 8-bit RGBA values in one word.
+uint32_t pack(const glm::vec3& color) noexcept {
+  uint32_t result = 0xff000000;
+  for (int k = 0; k < 3; ++k)
+    result |= uint32_t(lround(255.0f * clamp(color[k], 0.0f, 1.0f))) << 8 * k;
+  return result;
+}
+
+// Transformation of vertices from storage space into clip space.
+// Linear axis scales are affine and therefore folded into the matrix.
+// Then a block of vertices is transformed by one loop without branches
+// into separate coordinate arrays which compilers vectorize.
+class clip_transform {
+ public:
+  clip_transform(const axis_scaling& scaling, const glm::mat4& mvp)
+      : scaling_{scaling}, matrix_{mvp} {
+    linear_ = all_of(begin(scaling.scales), end(scaling.scales),
+                     [](auto s) { return s == axis_scale::linear; });
+    if (linear_)
+      matrix_ = glm::translate(glm::scale(mvp, scaling.factor),
+                               -scaling.offset);
+  }
+
+  glm::vec4 operator()(const glm::vec3& v) const noexcept {
+    return matrix_ * glm::vec4(linear_ ? v : scaling_.apply(v), 1.0f);
+  }
+
+  void operator()(span<const glm::vec3> vertices,
+                  array<glm::vec4, block_size>& clip) const noexcept {
+    if (!linear_) {
+      for (size_t i = 0; i < vertices.size(); ++i)
+        clip[i] = (*this)(vertices[i]);
+      return;
+    }
+    const auto& m = matrix_;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      const auto& v = vertices[i];
+      clip[i] = m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3];
+    }
+  }
+
+ private:
+  const axis_scaling& scaling_;
+  glm::mat4 matrix_;
+  bool linear_;
+};
+
+// Clip the segment against the near plane given by z = -w in clip space.
+bool clip_near(glm::vec4& a, glm::vec4& b) noexcept {
+  const auto da = a.z + a.w;
+  const auto db = b.z + b.w;
+  if (da < 0.0f && db < 0.0f) return false;
+  if (da < 0.0f) a += (b - a) * (da / (da - db));
+  if (db < 0.0f) b += (a - b) * (db / (db - da));
+  return true;
+}
+
+// Liang-Barsky clipping of the segment against the given rectangle.
+bool clip_rectangle(glm::vec2& p,
+                    glm::vec2& q,
+                    const glm::vec2& min,
+                    const glm::vec2& max) noexcept {
+  const auto d = q - p;
+  float t0 = 0.0f, t1 = 1.0f;
+  const auto clip = [&](float denominator, float numerator) {
+    if (denominator == 0.0f) return numerator <= 0.0f;
+    const auto t = numerator / denominator;
+    if (denominator < 0.0f) {
+      if (t > t1) return false;
+      t0 = std::max(t0, t);
+    } else {
+      if (t < t0) return false;
+      t1 = std::min(t1, t);
+    }
+    return true;
+  };
+  if (!clip(-d.x, p.x - min.x) || !clip(d.x, max.x - p.x) ||
+      !clip(-d.y, p.y - min.y) || !clip(d.y, max.y - p.y))
+    return false;
+  q = p + t1 * d;
+  p = p + t0 * d;
+  return true;
+}
+
+}  // namespace
+
+software_rasterizer::software_rasterizer(int width, int height)
+    : width_{width},
+      height_{height},
+      tiles_x_{size_t(width + tile_size - 1) / tile_size} {
+  if (width <= 0 || height <= 0)
+    throw runtime_error("Failed to create image of size " + to_string(width) +
+                        "x" + to_string(height) + ".");
+  const size_t tiles_y = (height + tile_size - 1) / tile_size;
+  pixels_.resize(tiles_x_ * tiles_y * tile_size * tile_size);
+}
+
+void software_rasterizer::set(int x, int y, uint32_t color) noexcept {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+  // Threads only ever write the same color during a draw call.
+  atomic_ref<uint32_t>{pixels_[index(x, y)]}.store(color,
+                                                    memory_order_relaxed);
+}
+
+void software_rasterizer::clear(const glm::vec3& color) {
+  const auto c = pack(color);
+  parallel_chunks(pixels_.size(), [&](size_t first, size_t last, size_t) {
+    fill(begin(pixels_) + first, begin(pixels_) + last, c);
+  });
+}
+
+void software_rasterizer::draw_points(span<const glm::vec3> vertices,
+                                      const axis_scaling& scaling,
+                                      const glm::mat4& mvp,
+                                      const glm::vec3& color,
+                                      int size) {
+  const clip_transform transform{scaling, mvp};
+  const auto c = pack(color);
+  const glm::vec2 half_screen{0.5f * width_, 0.5f * height_};
+  const int low = -(size - 1) / 2;
+  const int high = size / 2;
+  parallel_chunks(vertices.size(), [&](size_t first, size_t last, size_t) {
+    array<glm::vec4, block_size> clip;
+    for (auto i = first; i < last; i += block_size) {
+      const auto block = vertices.subspan(i, min(block_size, last - i));
+      transform(block, clip);
+      for (size_t j = 0; j < block.size(); ++j) {
+        const auto& p = clip[j];
+        if (p.w <= 0.0f || abs(p.z) > p.w) continue;
+        const int x = int(floor((p.x / p.w + 1.0f) * half_screen.x));
+        const int y = int(floor((1.0f - p.y / p.w) * half_screen.y));
+        for (int dy = low; dy <= high; ++dy)
+          for (int dx = low; dx <= high; ++dx) set(x + dx, y + dy, c);
+      }
+    }
+  });
+}
+
+void software_rasterizer::draw_lines(span<const glm::vec3> vertices,
+                                     span<const edge> edges,
+                                     const axis_scaling& scaling,
+                                     const glm::mat4& mvp,
+                                     const glm::vec3& color,
+                                     int line_width) {
+  const clip_transform transform{scaling, mvp};
+  const auto c = pack(color);
+  const glm::vec2 half_screen{0.5f * width_, 0.5f * height_};
+  const auto to_screen = [&](const glm::vec4& p) {
+    return glm::vec2{(p.x / p.w + 1.0f) * half_screen.x,
+                     (1.0f - p.y / p.w) * half_screen.y};
+  };
+  // Segments are clipped with a margin to not cut off thick lines.
+  const glm::vec2 margin{float(line_width)};
+  const glm::vec2 min_screen = -margin;
+  const glm::vec2 max_screen = glm::vec2{width_, height_} + margin;
+  const int low = -(line_width - 1) / 2;
+  const int high = line_width / 2;
+  parallel_chunks(
+      edges.size(),
+      [&](size_t first, size_t last, size_t) {
+        for (auto i = first; i < last; ++i) {
+          auto a = transform(vertices[edges[i].first]);
+          auto b = transform(vertices[edges[i].second]);
+          if (!clip_near(a, b)) continue;
+          auto p = to_screen(a);
+          auto q = to_screen(b);
+          if (!clip_rectangle(p, q, min_screen, max_screen)) continue;
+          // Step along the major axis and widen the line along the minor.
+          const auto d = q - p;
+          const bool x_major = abs(d.x) >= abs(d.y);
+          const int steps = int(ceil(max(abs(d.x), abs(d.y))));
+          const auto step = (steps > 0) ? d / float(steps) : glm::vec2{0.0f};
+          for (int k = 0; k <= steps; ++k) {
+            const auto s = p + float(k) * step;
+            const int x = int(floor(s.x));
+            const int y = int(floor(s.y));
+            for (int o = low; o <= high; ++o) {
+              if (x_major)
+                set(x, y + o, c);
+              else
+                set(x + o, y, c);
+            }
+          }
+        }
+      },
+      1 << 14);
+}
+
+glm::vec3 software_rasterizer::pixel(int x, int y) const noexcept {
+  const auto p = pixels_[index(x, y)];
+  return glm::vec3{p & 0xff, (p >> 8) & 0xff, (p >> 16) & 0xff} / 255.0f;
+}
+
+vector<uint32_t> software_rasterizer::rows() const {
+  vector<uint32_t> result(size_t(width_) * height_);
+  parallel_chunks(
+      height_,
+      [&](size_t first, size_t last, size_t) {
+        for (auto y = first; y < last; ++y)
+          for (int x = 0; x < width_; ++x)
+            result[y * width_ + x] = pixels_[index(x, y)];
+      },
+      64);
+  return result;
+}
+
+void software_rasterizer::write_ppm(const string& path) const {
+  fstream file{path, ios::out | ios::binary | ios::trunc};
+  if (!file.is_open())
+    throw runtime_error("Failed to open file '" + path + "' for writing.");
+  file << "P6\n" << width_ << ' ' << height_ << "\n255\n";
+  // Tiles are written row by row without the alpha channel.
+  vector<char> row(3 * size_t(width_));
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      const auto p = pixels_[index(x, y)];
+      for (int k = 0; k < 3; ++k) row[3 * x + k] = char(p >> 8 * k);
+    }
+    file.write(row.data(), row.size());
+  }
+  if (!file) throw runtime_error("Failed to write file '" + path + "'.");
+}
+
+}  // namespace vipo
@@ -0,0 +1,69 @@
+#pragma once
+// STL
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "axis_scaling.hpp"
+#include "frontier_file.hpp"
+
+namespace vipo {
+
+// CPU fallback for machines without a usable OpenGL context.
+// Points and lines are transformed like in the vertex shader and
+// rasterized in parallel chunks on the shared thread pool.
+// There is no depth buffer because every draw call uses a single color.
+// So the result does not depend on the order in which threads write pixels
+// and no primitives have to be sorted into tiles before rasterization.
+// Pixels are stored in 8x8 tiles such that nearby points and line segments
+// write to the same cache lines.
+class software_rasterizer {
+ public:
+  software_rasterizer(int width, int height);
+
+  int width() const noexcept { return width_; }
+  int height() const noexcept { return height_; }
+
+  void clear(const glm::vec3& color);
+  // Draw every vertex as square of 'size' pixels.
+  void draw_points(std::span<const glm::vec3> vertices,
+                   const axis_scaling& scaling,
+                   const glm::mat4& mvp,
+                   const glm::vec3& color,
+                   int size);
+  // Draw every edge as line of 'line_width' pixels.
+  // Lines are clipped at the near plane.
+  void draw_lines(std::span<const glm::vec3> vertices,
+                  std::span<const edge> edges,
+                  const axis_scaling& scaling,
+                  const glm::mat4& mvp,
+                  const glm::vec3& color,
+                  int line_width);
+
+  // Color of the pixel with origin in the upper left corner.
+  glm::vec3 pixel(int x, int y) const noexcept;
+  // Packed RGBA pixels row by row from the top, e.g. for sending frames.
+  std::vector<uint32_t> rows() const;
+  // Write the image as binary PPM file.
+  void write_ppm(const std::string& path) const;
+
+ private:
+  static constexpr int tile_size = 8;
+
+  size_t index(int x, int y) const noexcept {
+    return (size_t(y / tile_size) * tiles_x_ + x / tile_size) * tile_size *
+               tile_size +
+           (y % tile_size) * tile_size + x % tile_size;
+  }
+  void set(int x, int y, uint32_t color) noexcept;
+
+  int width_;
+  int height_;
+  size_t tiles_x_;
+  std::vector<uint32_t> pixels_{};
+};
+
+}  // namespace vipo
@@ -0,0 +1,54 @@
+#pragma once
+// STL
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace vipo {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Both indices only grow and are reduced modulo the capacity on access.
+// Each index lives on its own cache line such that the producer
+// and the consumer do not invalidate each other's cache lines.
+template <typename T>
+class spsc_queue {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit spsc_queue(size_t capacity)
+      : mask_{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1},
+        slots_{std::make_unique<T[]>(mask_ + 1)} {}
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  // Called by the producer. Returns false if the queue is full.
+  bool try_push(T&& value) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_) return false;
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Called by the consumer. Returns false if the queue is empty.
+  bool try_pop(T& value) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+    value = std::exchange(slots_[head & mask_], T{});
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr size_t cache_line = 64;
+
+  const size_t mask_;
+  std::unique_ptr<T[]> slots_;
+  alignas(cache_line) std::atomic<size_t> head_ = 0;
+  alignas(cache_line) std::atomic<size_t> tail_ = 0;
+};
+
+}  // namespace vipo
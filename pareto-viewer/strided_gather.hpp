@@ -0,0 +1,117 @@
+#pragma once
+// STL
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+//
+#include "parallel.hpp"
+
+namespace vipo {
+
+// Scalar element types of binary input formats.
+enum class scalar_type {
+  int8,
+  uint8,
+  int16,
+  uint16,
+  int32,
+  uint32,
+  int64,
+  uint64,
+  float32,
+  float64
+};
+
+constexpr size_t size_of(scalar_type type) noexcept {
+  constexpr size_t sizes[] = {1, 1, 2, 2, 4, 4, 8, 8, 4, 8};
+  return sizes[size_t(type)];
+}
+
+namespace detail {
+
+template <typename T, typename Out>
+void gather_values(const char* data,
+                   size_t stride,
+                   size_t count,
+                   bool swap,
+                   Out* out,
+                   size_t out_stride) {
+  parallel_chunks(count, [&](size_t first, size_t last, size_t) {
+    if (!swap) {
+      // Simple loop with constant strides the compiler can vectorize.
+      for (auto i = first; i < last; ++i) {
+        T x;
+        std::memcpy(&x, data + i * stride, sizeof(T));
+        out[i * out_stride] = Out(x);
+      }
+      return;
+    }
+    for (auto i = first; i < last; ++i) {
+      char bytes[sizeof(T)];
+      std::reverse_copy(data + i * stride, data + i * stride + sizeof(T),
+                        bytes);
+      T x;
+      std::memcpy(&x, bytes, sizeof(T));
+      out[i * out_stride] = Out(x);
+    }
+  });
+}
+
+}  // namespace detail
+
+// Convert 'count' values of the given type which are 'stride' bytes apart
+// and write them 'out_stride' elements apart. Data may be unaligned.
+// Values in the non-native byte order have to be swapped.
+// The loop is specialized for every type and runs in parallel chunks.
+template <typename Out>
+void gather(scalar_type type,
+            const char* data,
+            size_t stride,
+            size_t count,
+            bool swap,
+            Out* out,
+            size_t out_stride) {
+  using namespace detail;
+  switch (type) {
+    case scalar_type::int8:
+      return gather_values<int8_t>(data, stride, count, false, out, out_stride);
+    case scalar_type::uint8:
+      return gather_values<uint8_t>(data, stride, count, false, out,
+                                    out_stride);
+    case scalar_type::int16:
+      return gather_values<int16_t>(data, stride, count, swap, out,
+                                    out_stride);
+    case scalar_type::uint16:
+      return gather_values<uint16_t>(data, stride, count, swap, out,
+                                     out_stride);
+    case scalar_type::int32:
+      return gather_values<int32_t>(data, stride, count, swap, out,
+                                    out_stride);
+    case scalar_type::uint32:
+      return gather_values<uint32_t>(data, stride, count, swap, out,
+                                     out_stride);
+    case scalar_type::int64:
+      return gather_values<int64_t>(data, stride, count, swap, out,
+                                    out_stride);
+    case scalar_type::uint64:
+      return gather_values<uint64_t>(data, stride, count, swap, out,
+                                     out_stride);
+    case scalar_type::float32:
+      return gather_values<float>(data, stride, count, swap, out, out_stride);
+    case scalar_type::float64:
+      return gather_values<double>(data, stride, count, swap, out,
+                                   out_stride);
+  }
+}
+
+// Read a single value of the given type from an arbitrary address.
+template <typename Out>
+inline Out read_scalar(scalar_type type, const char* data, bool swap) {
+  Out out;
+  gather(type, data, 0, 1, swap, &out, 0);
+  return out;
+}
+
+}  // namespace vipo
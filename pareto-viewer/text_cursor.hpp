@@ -0,0 +1,81 @@
+#pragma once
+// STL
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace vipo {
+
+// Forward cursor over a memory-mapped text without any copies.
+// Tokens are separated by spaces and tabs. Numbers are parsed
+// by 'std::from_chars' directly from the mapped memory.
+class text_cursor {
+ public:
+  text_cursor(const char* first, const char* last, size_t line = 1) noexcept
+      : p_{first}, end_{last}, line_{line} {}
+
+  bool done() const noexcept { return p_ == end_; }
+  const char* position() const noexcept { return p_; }
+  size_t line() const noexcept { return line_; }
+
+  // Skip spaces, tabs, and carriage returns but stay on the current line.
+  void skip_spaces() noexcept {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) ++p_;
+  }
+
+  bool at_line_end() noexcept {
+    skip_spaces();
+    return p_ == end_ || *p_ == '\n';
+  }
+
+  // Move to the beginning of the next line.
+  void next_line() noexcept {
+    while (p_ != end_ && *p_ != '\n') ++p_;
+    if (p_ != end_) {
+      ++p_;
+      ++line_;
+    }
+  }
+
+  // Return the next token of the current line or an empty view.
+  std::string_view token() noexcept {
+    skip_spaces();
+    const auto first = p_;
+    while (p_ != end_ && *p_ != ' ' && *p_ != '\t' && *p_ != '\r' &&
+           *p_ != '\n')
+      ++p_;
+    return {first, size_t(p_ - first)};
+  }
+
+  // Parse the next token of the current line as number. Missing values,
+  // out-of-range values, and trailing garbage are reported with
+  // the line number by throwing 'std::runtime_error'.
+  template <typename T>
+  T number() {
+    const auto t = token();
+    T value{};
+    const auto [last, error] = std::from_chars(t.data(), t.data() + t.size(),
+                                               value);
+    if (error == std::errc::result_out_of_range) fail(t, "is out of range");
+    if (t.empty() || error != std::errc{} || last != t.data() + t.size())
+      fail(t, "is not a valid number");
+    return value;
+  }
+
+  [[noreturn]] void fail(std::string_view t, const char* reason) const {
+    if (t.empty())
+      throw std::runtime_error("Failed to parse line " +
+                               std::to_string(line_) + ". A value is missing.");
+    throw std::runtime_error("Failed to parse line " + std::to_string(line_) +
+                             ". '" + std::string(t) + "' " + reason + ".");
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+  size_t line_;
+};
+
+}  // namespace vipo
@@ -0,0 +1,302 @@
+#include "text_frontier.hpp"
+// STL
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+//
+#include "parallel.hpp"
+#include "parse_arena.hpp"
+#include "text_cursor.hpp"
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+// Return the beginning of the next line.
+inline const char* next_line(const char* p, const char* end) {
+  const auto n = static_cast<const char*>(memchr(p, '\n', end - p));
+  return n ? n + 1 : end;
+}
+
+inline bool is_space(char c) noexcept {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Check whether the line starts with a vertex record.
+inline bool is_vertex(const char* p, const char* end) noexcept {
+  while (p != end && is_space(*p)) ++p;
+  return p != end && *p == 'v' &&
+         (p + 1 == end || is_space(p[1]) || p[1] == '\n');
+}
+
+// Parse the vertex reference of an 'l' or 'f' record and return
+// its zero-based index. 'vertex_count' is the number of vertices
+// defined before the current line.
+uint64_t parse_index(text_cursor& cursor,
+                     text_dialect dialect,
+                     uint64_t vertex_count) {
+  if (dialect == text_dialect::native) return cursor.number<uint64_t>();
+  const auto token = cursor.token();
+  // Only the vertex index in front of the first slash is used.
+  const auto digits = token.substr(0, token.find('/'));
+  int64_t index{};
+  const auto [last, error] =
+      from_chars(digits.data(), digits.data() + digits.size(), index);
+  if (error == errc::result_out_of_range) cursor.fail(token, "is out of range");
+  if (digits.empty() || error != errc{} ||
+      last != digits.data() + digits.size())
+    cursor.fail(token, "is not a valid index");
+  if (index > 0) return uint64_t(index - 1);
+  if (index == 0 || uint64_t(-index) > vertex_count)
+    cursor.fail(token, "references a non-existing vertex");
+  return vertex_count - uint64_t(-index);
+}
+
+// Split the data into chunks at line boundaries.
+vector<const char*> split_lines(const char* first, const char* last) {
+  const size_t size = last - first;
+  const auto chunk_count = parallel_chunk_count(size, size_t{1} << 20);
+  vector<const char*> bounds(chunk_count + 1, last);
+  bounds[0] = first;
+  for (size_t i = 1; i < chunk_count; ++i)
+    bounds[i] =
+        next_line(max(first + i * size / chunk_count, bounds[i - 1]), last);
+  return bounds;
+}
+
+}  // namespace
+
+size_t parse_text_lines(const char* first,
+                        const char* last,
+                        size_t first_line,
+                        text_dialect dialect,
+                        large_vector<glm::dvec3>& objectives,
+                        large_vector<edge>& edges) {
+  const auto bounds = split_lines(first, last);
+  const auto chunk_count = bounds.size() - 1;
+
+  // Negative indices and error messages need the number of vertices
+  // and lines in front of every chunk. Counting them is much cheaper
+  // than parsing and allows to write all vertices to their final place.
+  vector<uint64_t> vertex_offsets(chunk_count + 1, objectives.size());
+  vector<size_t> line_offsets(chunk_count + 1, first_line);
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) {
+          uint64_t vertices = 0;
+          size_t lines = 0;
+          const auto end = bounds[chunk + 1];
+          for (auto p = bounds[chunk]; p < end; p = next_line(p, end)) {
+            vertices += is_vertex(p, end);
+            ++lines;
+          }
+          vertex_offsets[chunk + 1] = vertices;
+          line_offsets[chunk + 1] = lines;
+        }
+      },
+      1);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    vertex_offsets[i + 1] += vertex_offsets[i];
+    line_offsets[i + 1] += line_offsets[i];
+  }
+
+  objectives.resize(vertex_offsets.back());
+  // Edges of a chunk grow in an arena sized for one edge per line
+  // that is no vertex, which is exact for files of single edges.
+  deque<parse_arena> arenas{};
+  vector<pmr::vector<edge>> chunk_edges{};
+  chunk_edges.reserve(chunk_count);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    const auto lines = line_offsets[i + 1] - line_offsets[i];
+    const auto vertices = vertex_offsets[i + 1] - vertex_offsets[i];
+    arenas.emplace_back((lines - vertices) * sizeof(edge));
+    chunk_edges.emplace_back(arenas[i].resource());
+  }
+  vector<string> errors(chunk_count);
+  const auto parse_chunk = [&](size_t chunk) {
+    auto& result = chunk_edges[chunk];
+    auto vertex_count = vertex_offsets[chunk];
+    text_cursor cursor{bounds[chunk], bounds[chunk + 1], line_offsets[chunk]};
+    pmr::vector<uint64_t> polygon{arenas[chunk].resource()};
+    try {
+      for (; !cursor.done(); cursor.next_line()) {
+        const auto command = cursor.token();
+        if (command.empty()) continue;
+        if (command == "v") {
+          auto& v = objectives[vertex_count++];
+          for (int k = 0; k < 3; ++k) v[k] = cursor.number<double>();
+        } else if (command == "l") {
+          auto previous = parse_index(cursor, dialect, vertex_count);
+          do {
+            const auto next = parse_index(cursor, dialect, vertex_count);
+            result.emplace_back(previous, next);
+            previous = next;
+          } while (!cursor.at_line_end());
+        } else if (command == "f" && dialect == text_dialect::obj) {
+          polygon.clear();
+          while (!cursor.at_line_end())
+            polygon.push_back(parse_index(cursor, dialect, vertex_count));
+          if (polygon.size() < 3)
+            cursor.fail(command, "has less than three vertices");
+          for (size_t i = 0; i < polygon.size(); ++i)
+            result.emplace_back(polygon[i],
+                                polygon[(i + 1) % polygon.size()]);
+        } else if (dialect == text_dialect::native &&
+                   command.front() != '#') {
+          throw runtime_error("Failed to parse line " +
+                              to_string(cursor.line()) + ". Command '" +
+                              string(command) + "' is unknown.");
+        }
+        // OBJ comments, normals, texture coordinates, groups, materials,
+        // and all other records do not contribute to the frontier.
+      }
+    } catch (exception& e) {
+      errors[chunk] = e.what();
+    }
+  };
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) parse_chunk(chunk);
+      },
+      1);
+  for (const auto& error : errors)
+    if (!error.empty()) throw runtime_error(error);
+
+  // Concatenate the edges in their original order.
+  size_t edge_count = edges.size();
+  vector<size_t> edge_offsets(chunk_count);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    edge_offsets[i] = edge_count;
+    edge_count += chunk_edges[i].size();
+  }
+  edges.resize(edge_count);
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) {
+          copy(begin(chunk_edges[chunk]), end(chunk_edges[chunk]),
+               begin(edges) + edge_offsets[chunk]);
+        }
+      },
+      1);
+  return line_offsets.back() - first_line;
+}
+
+size_t parse_text_rows(const char* first,
+                       const char* last,
+                       size_t first_line,
+                       size_t row_size,
+                       const std::array<size_t, 3>& columns,
+                       large_vector<glm::dvec3>& objectives) {
+  const auto bounds = split_lines(first, last);
+  const auto chunk_count = bounds.size() - 1;
+
+  // Count the rows and lines in front of every chunk
+  // such that all rows are written to their final place.
+  vector<size_t> row_offsets(chunk_count + 1, objectives.size());
+  vector<size_t> line_offsets(chunk_count + 1, first_line);
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) {
+          size_t rows = 0;
+          size_t lines = 0;
+          const auto end = bounds[chunk + 1];
+          for (text_cursor cursor{bounds[chunk], end}; !cursor.done();
+               cursor.next_line()) {
+            rows += !cursor.at_line_end();
+            ++lines;
+          }
+          row_offsets[chunk + 1] = rows;
+          line_offsets[chunk + 1] = lines;
+        }
+      },
+      1);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    row_offsets[i + 1] += row_offsets[i];
+    line_offsets[i + 1] += line_offsets[i];
+  }
+
+  objectives.resize(row_offsets.back());
+  vector<string> errors(chunk_count);
+  parallel_chunks(
+      chunk_count,
+      [&](size_t first, size_t last, size_t) {
+        for (auto chunk = first; chunk < last; ++chunk) {
+          auto row = row_offsets[chunk];
+          text_cursor cursor{bounds[chunk], bounds[chunk + 1],
+                             line_offsets[chunk]};
+          try {
+            for (; !cursor.done(); cursor.next_line()) {
+              if (cursor.at_line_end()) continue;
+              auto& v = objectives[row++];
+              for (size_t p = 0; p < row_size; ++p) {
+                bool selected = false;
+                // Unselected values are only checked for presence
+                // like the properties of other elements.
+                for (int k = 0; k < 3; ++k) {
+                  if (columns[k] != p) continue;
+                  v[k] = cursor.number<double>();
+                  selected = true;
+                  break;
+                }
+                if (selected) continue;
+                if (const auto t = cursor.token(); t.empty())
+                  cursor.fail(t, "is missing");
+              }
+              if (!cursor.at_line_end())
+                cursor.fail(cursor.token(), "is an unexpected value");
+            }
+          } catch (exception& e) {
+            errors[chunk] = e.what();
+          }
+        }
+      },
+      1);
+  for (const auto& error : errors)
+    if (!error.empty()) throw runtime_error(error);
+  return line_offsets.back() - first_line;
+}
+
+void parse_text_stream(const function<span<const char>()>& next_block,
+                       text_dialect dialect,
+                       large_vector<glm::dvec3>& objectives,
+                       large_vector<edge>& edges) {
+  // The incomplete last line of the previous block.
+  string rest{};
+  size_t line = 1;
+  for (auto block = next_block(); !block.empty(); block = next_block()) {
+    const auto first = block.data();
+    const auto last = first + block.size();
+    const auto first_end =
+        static_cast<const char*>(memchr(first, '\n', block.size()));
+    if (!first_end) {
+      rest.append(first, last);
+      continue;
+    }
+    // Complete the line that started in front of this block.
+    rest.append(first, first_end + 1);
+    line += parse_text_lines(rest.data(), rest.data() + rest.size(), line,
+                             dialect, objectives, edges);
+    // Lines that are completely contained in the block are parsed in place.
+    auto end = last;
+    while (end[-1] != '\n') --end;
+    line += parse_text_lines(first_end + 1, end, line, dialect, objectives,
+                             edges);
+    rest.assign(end, last);
+  }
+  parse_text_lines(rest.data(), rest.data() + rest.size(), line, dialect,
+                   objectives, edges);
+}
+
+}  // namespace vipo
@@ -0,0 +1,54 @@
+#pragma once
+// STL
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+//
+#include <glm/glm.hpp>
+//
+#include "frontier_file.hpp"
+
+namespace vipo {
+
+// Line-based frontier formats consisting of 'v' and 'l' records.
+// The native format uses zero-based indices and rejects unknown records.
+// Wavefront OBJ uses one-based and negative indices, adds 'f' records,
+// and ignores unknown records.
+enum class text_dialect { native, obj };
+
+// Parse the lines in the given range in parallel chunks and append
+// their vertices and edges. Indices are not checked against the number
+// of vertices because vertices may be defined after their edges.
+// 'first_line' is the number of the first line used in error messages.
+// Returns the number of parsed lines.
+size_t parse_text_lines(const char* first,
+                        const char* last,
+                        size_t first_line,
+                        text_dialect dialect,
+                        large_vector<glm::dvec3>& objectives,
+                        large_vector<edge>& edges);
+
+// Parse rows of whitespace-separated numbers like the vertex element of
+// an ASCII PLY file in parallel chunks and append one vertex per row.
+// Every row consists of 'row_size' values. Value 'columns[k]' of a row
+// is the k-th objective. Blank lines are skipped. 'first_line' is the
+// number of the first line used in error messages.
+// Returns the number of parsed lines.
+size_t parse_text_rows(const char* first,
+                       const char* last,
+                       size_t first_line,
+                       size_t row_size,
+                       const std::array<size_t, 3>& columns,
+                       large_vector<glm::dvec3>& objectives);
+
+// Parse consecutive blocks of text returned by 'next_block' until
+// it returns an empty block. Blocks may end in the middle of a line.
+// Only the incomplete lines at block boundaries are copied.
+void parse_text_stream(const std::function<std::span<const char>()>& next_block,
+                       text_dialect dialect,
+                       large_vector<glm::dvec3>& objectives,
+                       large_vector<edge>& edges);
+
+}  // namespace vipo
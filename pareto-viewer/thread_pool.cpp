@@ -0,0 +1,184 @@
+#include "thread_pool.hpp"
+// STL
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace vipo {
+
+namespace {
+
+constexpr size_t no_queue = -1;
+
+// Pool and queue owned by a worker thread.
+thread_local thread_pool* current_pool = nullptr;
+thread_local size_t current_queue = no_queue;
+thread_local task_priority current_priority = task_priority::background;
+
+}  // namespace
+
+thread_pool& thread_pool::shared() {
+  static thread_pool pool{max<size_t>(1, thread::hardware_concurrency()) - 1};
+  return pool;
+}
+
+thread_pool::thread_pool(size_t worker_count) {
+  // Background jobs need at least one worker to make progress
+  // while no thread is waiting.
+  worker_count = max<size_t>(worker_count, 1);
+  for (size_t i = 0; i < worker_count; ++i)
+    queues_.push_back(make_unique<queue>());
+  for (size_t i = 0; i < worker_count; ++i)
+    workers_.emplace_back([this, i] { work(i); });
+}
+
+thread_pool::~thread_pool() {
+  {
+    scoped_lock lock{sleep_mutex_};
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+void thread_pool::submit(function<void()> task) {
+  submit(move(task), current_priority);
+}
+
+void thread_pool::submit(function<void()> task, task_priority priority) {
+  auto& q = (priority == task_priority::interactive) ? interactive_
+            : (current_pool == this) ? *queues_[current_queue]
+                                     : injected_;
+  {
+    scoped_lock lock{q.mutex};
+    q.entries.push_back({move(task), priority});
+  }
+  if (priority == task_priority::interactive) ++pending_interactive_;
+  ++pending_;
+  // Sleeping threads check the counters while holding the lock.
+  { scoped_lock lock{sleep_mutex_}; }
+  wake_.notify_all();
+}
+
+void thread_pool::notify() {
+  { scoped_lock lock{sleep_mutex_}; }
+  wake_.notify_all();
+}
+
+void thread_pool::help_until(const function<bool()>& done) {
+  const bool interactive_only = current_priority == task_priority::interactive;
+  while (!done()) {
+    if (run_one(interactive_only)) continue;
+    unique_lock lock{sleep_mutex_};
+    wake_.wait(lock, [&] {
+      return done() ||
+             (interactive_only ? pending_interactive_ : pending_) > 0;
+    });
+  }
+}
+
+void thread_pool::work(size_t index) {
+  current_pool = this;
+  current_queue = index;
+  while (true) {
+    if (run_one(false)) continue;
+    unique_lock lock{sleep_mutex_};
+    wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+    if (stop_ && pending_ == 0) return;
+  }
+}
+
+bool thread_pool::pop_front(queue& q, entry& e) {
+  scoped_lock lock{q.mutex};
+  if (q.entries.empty()) return false;
+  e = move(q.entries.front());
+  q.entries.pop_front();
+  return true;
+}
+
+bool thread_pool::pop_back(queue& q, entry& e) {
+  scoped_lock lock{q.mutex};
+  if (q.entries.empty()) return false;
+  e = move(q.entries.back());
+  q.entries.pop_back();
+  return true;
+}
+
+bool thread_pool::run_one(bool interactive_only) {
+  entry e{};
+  bool found = pop_front(interactive_, e);
+  if (!found && !interactive_only) {
+    // The newest own task is most likely still in the cache.
+    const auto self = (current_pool == this) ? current_queue : no_queue;
+    if (self != no_queue) found = pop_back(*queues_[self], e);
+    if (!found) found = pop_front(injected_, e);
+    // Steal the oldest task of another worker.
+    for (size_t i = 1; !found && i <= queues_.size(); ++i)
+      found = pop_front(*queues_[(self + i) % queues_.size()], e);
+  }
+  if (!found) return false;
+  if (e.priority == task_priority::interactive) --pending_interactive_;
+  --pending_;
+  const auto priority = exchange(current_priority, e.priority);
+  e.task();
+  current_priority = priority;
+  return true;
+}
+
+priority_scope::priority_scope(task_priority priority) noexcept
+    : previous_{exchange(current_priority, priority)} {}
+
+priority_scope::~priority_scope() {
+  current_priority = previous_;
+}
+
+task_group::~task_group() {
+  pool_.help_until([this] { return remaining_ == 0; });
+}
+
+void task_group::run(function<void()> task) {
+  ++remaining_;
+  pool_.submit([this, pool = &pool_, task = move(task)] {
+    try {
+      task();
+    } catch (...) {
+      scoped_lock lock{mutex_};
+      if (!error_) error_ = current_exception();
+    }
+    // The group may be destroyed as soon as the counter reaches zero.
+    if (--remaining_ == 0) pool->notify();
+  });
+}
+
+void task_group::wait() {
+  pool_.help_until([this] { return remaining_ == 0; });
+  if (error_) rethrow_exception(exchange(error_, nullptr));
+}
+
+task_graph::node task_graph::add(function<void()> task,
+                                 vector<node> dependencies) {
+  const auto index = tasks_.size();
+  for (const auto d : dependencies) tasks_[d].dependents.push_back(index);
+  tasks_.push_back({move(task), {}, dependencies.size()});
+  return index;
+}
+
+void task_graph::run(thread_pool& pool) {
+  const auto counts = make_unique<atomic<size_t>[]>(tasks_.size());
+  for (size_t i = 0; i < tasks_.size(); ++i)
+    counts[i] = tasks_[i].dependency_count;
+  task_group group{pool};
+  function<void(node)> start = [&](node i) {
+    group.run([&, i] {
+      tasks_[i].function();
+      for (const auto d : tasks_[i].dependents)
+        if (--counts[d] == 0) start(d);
+    });
+  };
+  for (size_t i = 0; i < tasks_.size(); ++i)
+    if (tasks_[i].dependency_count == 0) start(i);
+  group.wait();
+}
+
+}  // namespace vipo
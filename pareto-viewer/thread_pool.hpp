@@ -0,0 +1,132 @@
+#pragma once
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vipo {
+
+// Queued interactive tasks are always started before background tasks.
+// Running tasks are never interrupted. So long computations
+// have to be split into tasks to stay out of the way.
+enum class task_priority { background, interactive };
+
+// Work-stealing thread pool shared by all CPU-side processing such that
+// concurrent stages do not oversubscribe the machine. Every worker owns
+// a queue. Tasks spawned by a worker are pushed to and popped from the back
+// of its own queue while idle threads steal from the front of other queues.
+// Tasks of other threads and interactive tasks go to shared queues.
+// Threads waiting for tasks take part in the work instead of blocking.
+class thread_pool {
+ public:
+  // Pool with one worker less than hardware threads
+  // because a waiting thread is always helping.
+  static thread_pool& shared();
+
+  explicit thread_pool(size_t worker_count);
+  ~thread_pool();
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  size_t worker_count() const noexcept { return workers_.size(); }
+
+  // Enqueue a task that must not throw. Without a given priority,
+  // the priority of the current task or 'priority_scope' is inherited.
+  void submit(std::function<void()> task);
+  void submit(std::function<void()> task, task_priority priority);
+
+  // Run queued tasks on the calling thread until 'done' returns true and
+  // sleep while there is nothing to do. 'notify' has to be called after
+  // the state observed by 'done' has changed. Interactive threads only
+  // run interactive tasks to not get stuck in long background work.
+  void help_until(const std::function<bool()>& done);
+  void notify();
+
+ private:
+  struct entry {
+    std::function<void()> task;
+    task_priority priority;
+  };
+  struct queue {
+    std::mutex mutex{};
+    std::deque<entry> entries{};
+  };
+
+  void work(size_t index);
+  bool run_one(bool interactive_only);
+  bool pop_front(queue& q, entry& e);
+  bool pop_back(queue& q, entry& e);
+
+  queue interactive_{};
+  queue injected_{};
+  std::vector<std::unique_ptr<queue>> queues_{};
+  std::atomic<size_t> pending_ = 0;
+  std::atomic<size_t> pending_interactive_ = 0;
+  std::mutex sleep_mutex_{};
+  std::condition_variable wake_{};
+  bool stop_ = false;
+  std::vector<std::thread> workers_{};
+};
+
+// Set the priority of tasks submitted by the current thread.
+class priority_scope {
+ public:
+  explicit priority_scope(task_priority priority) noexcept;
+  ~priority_scope();
+  priority_scope(const priority_scope&) = delete;
+  priority_scope& operator=(const priority_scope&) = delete;
+
+ private:
+  task_priority previous_;
+};
+
+// Tasks whose completion can be awaited as a whole. The first exception
+// thrown by a task is rethrown by 'wait'. The destructor waits as well.
+class task_group {
+ public:
+  explicit task_group(thread_pool& pool = thread_pool::shared()) noexcept
+      : pool_{pool} {}
+  ~task_group();
+  task_group(const task_group&) = delete;
+  task_group& operator=(const task_group&) = delete;
+
+  void run(std::function<void()> task);
+  void wait();
+
+ private:
+  thread_pool& pool_;
+  std::atomic<size_t> remaining_ = 0;
+  std::mutex mutex_{};
+  std::exception_ptr error_{};
+};
+
+// Tasks with dependencies. A task is started as soon
+// as all the tasks it depends on have been completed.
+class task_graph {
+ public:
+  using node = size_t;
+
+  // Dependencies have to be added before.
+  node add(std::function<void()> task, std::vector<node> dependencies = {});
+
+  // Run all tasks and wait for them. If a task throws,
+  // its dependents are skipped and the exception is rethrown.
+  void run(thread_pool& pool = thread_pool::shared());
+
+ private:
+  struct task {
+    std::function<void()> function;
+    std::vector<node> dependents;
+    size_t dependency_count;
+  };
+  std::vector<task> tasks_{};
+};
+
+}  // namespace vipo
@@ -0,0 +1,1429 @@
+#include "viewer.hpp"
+// STL
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+//
+// glbinding handles the OpenGL
+// inclusion and extension loading.
+#include <glbinding/gl/gl.h>
+#include <glbinding/glbinding.h>
+//
+// Use GLFW as platform-independent library to create a window.
+// Because of glbinding, we do not want GLFW to include OpenGL.
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+//
+#include <glm/ext.hpp>
+//
+#include "axis_scaling.hpp"
+#include "background_job.hpp"
+#include "dirty_ranges.hpp"
+#include "line_batches.hpp"
+#include "memory_stats.hpp"
+#include "parallel.hpp"
+#include "picking.hpp"
+#include "remote_rendering.hpp"
+#include "software_rasterizer.hpp"
+#include "spsc_queue.hpp"
+#include "thread_pool.hpp"
+
+using namespace std;
+// glbinding puts OpenGL functions in namespace "gl".
+// To write compatible code, we open it.
+using namespace gl;
+
+namespace vipo {
+
+namespace {
+
+// Vertex and fragment shader source code.
+// We do not need newline characters at every line ending
+// due to the semicolons in the syntax of GLSL.
+// The per-axis scaling has to match vipo::axis_scaling::apply.
+const char* vertex_shader_text =
+    "#version 330 core\n"
+    "uniform mat4 MVP;"
+    "uniform ivec3 axis_scale;"
+    "uniform vec3 axis_offset;"
+    "uniform vec3 axis_factor;"
+    "uniform vec3 axis_center;"
+    "uniform vec3 axis_radius;"
+    "uniform vec3 axis_threshold;"
+    "uniform vec3 axis_min;"
+    "uniform vec3 axis_max;"
+    "in vec3 vPos;"
+    "float scale_axis(int k, float v){"
+    "  if (axis_scale[k] == 0) return (v - axis_offset[k]) * axis_factor[k];"
+    "  float x = axis_center[k] + axis_radius[k] * v;"
+    "  float y = (axis_scale[k] == 1)"
+    "    ? log(max(x, 1e-37))"
+    "    : sign(x) * log(1.0 + abs(x) / axis_threshold[k]);"
+    "  float extent = axis_max[k] - axis_min[k];"
+    "  if (extent <= 0.0) return 0.0;"
+    "  return clamp(2.0 * (y - axis_min[k]) / extent - 1.0, -1.0, 1.0);"
+    "}"
+    "void main(){"
+    "  vec3 p = vec3(scale_axis(0, vPos.x),"
+    "                scale_axis(1, vPos.y),"
+    "                scale_axis(2, vPos.z));"
+    "  gl_Position = MVP * vec4(p, 1.0);"
+    "}";
+const char* fragment_shader_text =
+    "#version 330 core\n"
+    "uniform vec4 color;"
+    "void main(){"
+    "  gl_FragColor = color;"
+    "}";
+
+// Initial Camera
+const glm::vec3 up{0, 0, 1};
+const glm::vec3 origin{0, 0, 0};
+constexpr float fov = 45.0f;
+constexpr float radius = 5.0f;
+constexpr float altitude = 0.0f;
+constexpr float azimuth = 0.0f;
+
+const array<pair<uint32_t, uint32_t>, 12> aabb_edges{
+    pair{0, 2},  // x
+    {0, 4},      // y
+    {0, 1},      // z
+    {1, 3},     {3, 2}, {5, 7}, {7, 6}, {6, 4}, {4, 5}, {1, 5}, {3, 7}, {2, 6}};
+
+// Number of frames the camera motion is extrapolated for prefetching.
+constexpr float prefetch_frames = 15.0f;
+// Modified vertices are uploaded in parts to not stall the rendering.
+constexpr size_t vertex_upload_budget = size_t{1} << 20;
+
+struct camera_state {
+  glm::vec3 origin;
+  float radius;
+  float altitude;
+  float azimuth;
+};
+
+// Compute the view matrix of a camera orbiting around the origin.
+glm::mat4 orbit_view(glm::vec3 origin,
+                     float radius,
+                     float altitude,
+                     float azimuth) {
+  const glm::vec3 camera{cos(altitude) * cos(azimuth),
+                         cos(altitude) * sin(azimuth), sin(altitude)};
+  return glm::lookAt(radius * camera + origin, origin, up);
+}
+
+// Camera movements by the mouse given in pixels.
+// They are shared by windows and clients of the render server.
+void orbit_camera(camera_state& c, glm::vec2 mouse_move) {
+  c.altitude += mouse_move.y * 0.01;
+  c.azimuth -= mouse_move.x * 0.01;
+  constexpr float bound = M_PI_2 - 1e-5f;
+  c.altitude = clamp(c.altitude, -bound, bound);
+}
+
+void pan_camera(camera_state& c, glm::vec2 mouse_move, int screen_height) {
+  glm::vec3 camera{cos(c.altitude) * cos(c.azimuth),
+                   cos(c.altitude) * sin(c.azimuth), sin(c.altitude)};
+  camera *= c.radius;
+  const auto camera_right = normalize(cross(-camera, up));
+  const auto camera_up = normalize(cross(camera_right, -camera));
+  const float pixel_size =
+      2.0f * tan(0.5f * fov * M_PI / 180.0f) / screen_height;
+  const auto scale = 1.3f * pixel_size * length(camera);
+  c.origin +=
+      -scale * mouse_move.x * camera_right + scale * mouse_move.y * camera_up;
+}
+
+void zoom_camera(camera_state& c, float scroll) {
+  c.radius *= exp(-0.1f * scroll);
+}
+
+}  // namespace
+
+struct viewer::impl {
+  // Every view has its own window, camera, and vertex arrays.
+  // Its context shares all buffers and the shader program
+  // with the context of the first view. So further views
+  // do not need any additional memory for the vertex data.
+  struct view_state {
+    // Window and OpenGL Context
+    impl* owner = nullptr;
+    size_t index = 0;
+    GLFWwindow* window = nullptr;
+    // Camera and UI of the event thread
+    camera_state camera{};
+    glm::vec2 old_mouse_pos{};
+    glm::vec2 mouse_pos{};
+    int screen_width = 0;
+    int screen_height = 0;
+    // Camera parameters as seen by the render thread.
+    camera_state frame_camera{};
+    // Camera parameters of the last frame to extrapolate the camera motion.
+    camera_state old_camera{};
+    // Size of the framebuffer as seen by the render thread.
+    int frame_width = 0;
+    int frame_height = 0;
+    // Transformation Matrices
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::mat4 mvp{1.0f};
+    // The vertex under the mouse cursor is picked by the render thread.
+    glm::vec2 pick_position{};
+    bool pick_requested = false;
+    // Index of the vertex under the mouse cursor.
+    size_t hovered = no_vertex;
+    // Title suffix with the objectives of the hovered vertex
+    string hover_text{};
+    // Time of the last title update with the memory usage
+    double memory_time = 0.0;
+    bool memory_shown = false;
+    // Vertex arrays cannot be shared between contexts.
+    GLuint aabb_vertex_array = 0;
+    GLuint surface_vertex_array = 0;
+  };
+
+  explicit impl(viewer_options o) : options{move(o)} {}
+  ~impl();
+
+  // Called without the data mutex. The surface job reads the borrowed
+  // data and has to stop before it changes. Waiting for it with the mutex
+  // being locked would block the render thread during a long sort or
+  // cache write. Returns whether the job was running.
+  bool stop_surface_job();
+  // Called with the data mutex being locked after the job has stopped.
+  void set_data(const viewer_data& data);
+  void set_chunked(const chunked_frontier& frontier);
+  void begin_edit(bool surface_job_stopped);
+  void invalidate(size_t first, size_t last);
+  void end_edit();
+  // Update bounds, axis scaling, and AABB after the data has changed.
+  void update_bounds();
+  // Set the corners of the AABB given in render space.
+  void set_aabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max);
+  // Compute the attainment surface of the current vertices in the background.
+  // The maximum of the AABB is used as reference point.
+  void start_surface_job();
+  // Number of vertices whether they are stored on the CPU or not.
+  size_t vertex_count() const noexcept {
+    return max(vertices.size(), objectives.size());
+  }
+  // Map the objectives again if their vertices have been released.
+  void restore_vertices();
+  // In GPU-resident mode, free the vertices of the objectives
+  // after they have been uploaded and are no longer read.
+  void release_vertices();
+  // Account the memory of the vertex storage.
+  void account_vertices();
+  // Vertices for queries on the CPU. Released vertices
+  // are mapped into the given buffer without being kept.
+  span<const glm::vec3> query_vertices(large_vector<glm::vec3>& buffer) const;
+
+  // Create windows, contexts, and the render thread.
+  void init();
+  // Handle window events. Returns false if a window has been closed.
+  bool process_events(double timeout);
+  void render_image(const string& path);
+  // Render the frontier without OpenGL as seen by the given camera.
+  software_rasterizer render_software(const camera_state& camera,
+                                      int width,
+                                      int height);
+  void serve(const string& path);
+  // Cycle through linear, logarithmic, and symlog scale of an axis.
+  void cycle_axis_scale(int k);
+
+  // Helper Functions of the Event Thread
+  // Create window with OpenGL context.
+  void init_window();
+  // Add the event handlers to the window of a view.
+  static void init_callbacks(GLFWwindow* window);
+  // Run the given command on the render thread before the next frame.
+  void post(function<void()> command);
+  // Function called by the event thread to handle the mouse.
+  void handle_input(size_t index);
+
+  // Helper Functions of the Render Thread
+  // Loop of the render thread from the creation to the deletion
+  // of all OpenGL objects.
+  void render_loop();
+  // Make the context of a view current on the render thread.
+  void make_current(size_t index);
+  // Set up the state and vertex arrays of a view in its context.
+  void init_view(size_t index);
+  // Upload everything that depends on the shown frontier.
+  void upload_frontier();
+  // Upload the lines again and recreate their vertex arrays in all views.
+  void upload_lines();
+  // Delete all OpenGL objects.
+  void free_vertex_data();
+  // Compile and link the shader program.
+  void init_shader();
+  // Set up vertex buffers for the AABB and the attainment surface.
+  void init_vertex_data();
+  // Upload the current axis scaling to the shader uniforms.
+  void upload_axis_scaling();
+  // Upload the corners of the AABB.
+  void upload_aabb();
+  // Upload the attainment surface into its buffers.
+  void upload_surface();
+  // Function called when window is resized.
+  void resize(size_t index, int width, int height);
+  // Function called to update variables in every application loop.
+  void update();
+  // Function called to update the matrices of a view in every frame.
+  void update_view(size_t index);
+  // Function called to render a view in every application loop.
+  void render(size_t index);
+
+  viewer_options options;
+
+  // Borrowed and derived data of the frontier. It is guarded
+  // by the data mutex because the render thread reads it
+  // while it may be modified by the owner.
+  mutex data_mutex{};
+  // Objective values are kept in double precision for reporting.
+  // The vertices are their float conversion in storage space
+  // or are directly borrowed from the owner. In GPU-resident mode,
+  // the storage is released and the vertices are empty.
+  span<const glm::dvec3> objectives{};
+  large_vector<glm::vec3> vertex_storage{};
+  span<const glm::vec3> vertices{};
+  memory_account vertex_memory{memory_pool::vertices};
+  // Edges are only copied while they are reordered for the upload.
+  span<const edge> edges{};
+  // Hash of the edges to detect a change of the topology.
+  uint64_t edge_hash = 0;
+  objective_transform transform{};
+  objective_bounds bounds{};
+  // Nonlinear axis scales are applied in the vertex shader.
+  array<axis_scale, 3> axis_scales{};
+  axis_scaling scaling{};
+  array<glm::vec3, 8> aabb_vertices{};
+  glm::mat4 model{1.0f};
+  // Incremented whenever the shown data changes.
+  uint64_t data_version = 0;
+  // Out-of-core mode for chunked frontier files larger than RAM.
+  // Vertices are then streamed from the memory-mapped file
+  // instead of being stored in the 'vertices' array.
+  const chunked_frontier* chunked = nullptr;
+  // The surface is computed in the background and shown progressively.
+  // Its job is restarted whenever the vertices change.
+  background_job<attainment_surface> surface_job{};
+  bool restart_surface_job = false;
+  function<void(const frontier_cache_entry&)> surface_handler{};
+  // Changes that have not been uploaded by the render thread.
+  // Modified vertices are uploaded over multiple frames.
+  bool frontier_changed = false;
+  bool lines_changed = false;
+  bool edited = false;
+  dirty_ranges vertex_changes{};
+  attainment_surface pending_surface{};
+  bool surface_pending = false;
+
+  // Handlers of the event thread
+  vector<pair<int, function<void()>>> key_handlers{};
+
+  // The event thread only handles window events and moves the camera.
+  // The render thread owns the OpenGL contexts and all data on the GPU.
+  // Changes are passed as commands which are run before the next frame.
+  bool is_initialized = false;
+  bool is_closed = false;
+  thread render_thread{};
+  atomic<bool> stop_rendering = false;
+  atomic<bool> render_stopped = false;
+  exception_ptr render_error{};
+  spsc_queue<function<void()>> render_commands{1024};
+  // Window titles can only be set by the event thread.
+  spsc_queue<pair<size_t, string>> window_titles{16};
+
+  // Attainment surface of the Pareto frontier
+  // with the maximum of the AABB as reference point.
+  attainment_surface surface{};
+  bool show_surface = true;
+  memory_account surface_memory{memory_pool::surface};
+  memory_account gpu_surface_memory{memory_pool::gpu_surface};
+  // Show the memory usage of all subsystems in the window titles.
+  bool show_memory = false;
+  // Vertex Data Handles
+  // The edges may need multiple buffers and draw calls.
+  line_batches lines{};
+  // Streaming of chunks in out-of-core mode.
+  unique_ptr<chunk_streamer> streamer{};
+  // AABB Handles
+  GLuint aabb_vertex_buffer = 0;
+  GLuint aabb_element_buffer = 0;
+  // Attainment Surface Handles
+  GLuint surface_vertex_buffer = 0;
+  GLuint surface_element_buffer = 0;
+  // Shader Handles
+  GLuint program = 0;
+  GLint mvp_location, vpos_location, color_location;
+  GLint axis_scale_location, axis_offset_location, axis_factor_location,
+      axis_center_location, axis_radius_location, axis_threshold_location,
+      axis_min_location, axis_max_location;
+  // Views are created before the render thread starts and never move.
+  vector<view_state> views{};
+};
+
+viewer::viewer(viewer_options options)
+    : self_{make_unique<impl>(move(options))} {}
+
+viewer::~viewer() = default;
+
+void viewer::show(const viewer_data& data) {
+  // Edges are only checked here. Rendering, picking, and the attainment
+  // surface index the vertices by them without any further checks.
+  const auto vertex_count =
+      data.vertices.empty() ? data.objectives.size() : data.vertices.size();
+  if (const auto i = find_invalid_edge(vertex_count, data.edges);
+      i != data.edges.size())
+    throw runtime_error("Failed to show frontier. Edge " + to_string(i) +
+                        " references a non-existing vertex.");
+  // The job is stopped without the lock like in 'stop_surface_job'.
+  self_->surface_job.cancel();
+  scoped_lock lock{self_->data_mutex};
+  self_->set_data(data);
+}
+
+void viewer::show(const chunked_frontier& frontier) {
+  self_->surface_job.cancel();
+  scoped_lock lock{self_->data_mutex};
+  self_->set_chunked(frontier);
+}
+
+viewer::edit_scope viewer::edit() {
+  return edit_scope{*self_};
+}
+
+void viewer::on_key(int key, function<void()> handler) {
+  self_->key_handlers.push_back({key, move(handler)});
+}
+
+void viewer::on_surface(function<void(const frontier_cache_entry&)> handler) {
+  scoped_lock lock{self_->data_mutex};
+  self_->surface_handler = move(handler);
+}
+
+bool viewer::poll() {
+  return self_->process_events(0.0);
+}
+
+void viewer::run() {
+  // The timeout keeps the camera moving while a mouse button is held.
+  while (self_->process_events(1.0 / 120)) {
+  }
+}
+
+void viewer::render_image(const string& path) {
+  self_->render_image(path);
+}
+
+void viewer::serve(const string& path) {
+  self_->serve(path);
+}
+
+viewer::edit_scope::edit_scope(impl& owner)
+    : owner_{owner}, lock_{owner.data_mutex, defer_lock} {
+  const auto stopped = owner_.stop_surface_job();
+  lock_.lock();
+  owner_.begin_edit(stopped);
+}
+
+viewer::edit_scope::~edit_scope() {
+  owner_.end_edit();
+}
+
+void viewer::edit_scope::invalidate(size_t first, size_t last) {
+  owner_.invalidate(first, last);
+}
+
+viewer::impl::~impl() {
+  // An uninitialized viewer has no windows.
+  if (!is_initialized) return;
+
+  // The render thread deletes the vertex data before it stops.
+  stop_rendering = true;
+  if (render_thread.joinable()) render_thread.join();
+
+  for (auto& v : views)
+    if (v.window) glfwDestroyWindow(v.window);
+  glfwTerminate();
+}
+
+void viewer::impl::set_data(const viewer_data& data) {
+  // The topology decides whether the old transform can be kept.
+  // So the edges are hashed first.
+  const auto new_edge_hash =
+      content_hash(reinterpret_cast<const char*>(data.edges.data()),
+                   data.edges.size() * sizeof(edge));
+  const auto new_count =
+      data.vertices.empty() ? data.objectives.size() : data.vertices.size();
+  const bool same_topology = !chunked && new_count == vertex_count() &&
+                             new_edge_hash == edge_hash;
+
+  // The objective transform is kept for the same topology such that
+  // unmodified objectives are mapped to bitwise identical vertices.
+  // Otherwise, it is fitted to the new objectives to keep the precision.
+  // Given float vertices are always used without a transform.
+  auto new_transform = transform;
+  if (!data.vertices.empty())
+    new_transform = data.objectives.empty() ? objective_transform{}
+                                            : data.transform;
+  // Vertices may have been released in GPU-resident mode. So previous
+  // objectives are enough to keep the transform.
+  else if (!same_topology || objectives.empty())
+    new_transform =
+        fit_objective_transform(compute_objective_bounds(data.objectives));
+
+  large_vector<glm::vec3> storage{};
+  memory_account storage_memory{memory_pool::vertices};
+  span<const glm::vec3> new_vertices = data.vertices;
+  vector<vector<pair<size_t, size_t>>> changes{};
+  task_graph graph{};
+  const auto map = graph.add([&] {
+    if (!new_vertices.empty()) return;
+    transform_objectives(data.objectives, new_transform, storage);
+    storage_memory.set(storage.capacity() * sizeof(glm::vec3));
+    new_vertices = storage;
+  });
+  graph.add(
+      [&] {
+        if (!same_topology) return;
+        const auto n = vertex_count();
+        // Released vertices are mapped again from the old objectives.
+        const auto changed = [&](size_t i) {
+          return (vertices.empty() ? transform.to_render(objectives[i])
+                                   : vertices[i]) != new_vertices[i];
+        };
+        // Compare the vertices in parallel and collect runs of changes.
+        changes.resize(parallel_chunk_count(n));
+        parallel_chunks(n, [&](size_t first, size_t last, size_t chunk) {
+          for (auto i = first; i < last;) {
+            if (!changed(i)) {
+              ++i;
+              continue;
+            }
+            const auto begin = i;
+            while (i < last && changed(i)) ++i;
+            changes[chunk].push_back({begin, i});
+          }
+        });
+      },
+      {map});
+  graph.run();
+
+  // The buffer of the storage is moved and the span stays valid.
+  objectives = data.objectives;
+  edges = data.edges;
+  vertex_storage = move(storage);
+  vertices = new_vertices;
+  storage_memory.set(0);
+  account_vertices();
+  transform = new_transform;
+  chunked = nullptr;
+  model = glm::mat4{1.0f};
+  if (same_topology) {
+    for (const auto& runs : changes)
+      for (const auto& [first, last] : runs) vertex_changes.mark(first, last);
+  } else {
+    vertex_changes.clear();
+    edge_hash = new_edge_hash;
+    lines_changed = true;
+  }
+  update_bounds();
+
+  // The old surface is shown until the first faces of the new one arrive.
+  if (data.surface) {
+    pending_surface = *data.surface;
+    surface_pending = true;
+  } else {
+    start_surface_job();
+  }
+}
+
+void viewer::impl::set_chunked(const chunked_frontier& frontier) {
+  chunked = &frontier;
+  objectives = {};
+  vertex_storage = {};
+  vertices = {};
+  account_vertices();
+  edges = {};
+  edge_hash = 0;
+  vertex_changes.clear();
+  transform = {};
+  // Chunked frontiers are not normalized and only support linear axes.
+  axis_scales = {};
+  scaling = {};
+  const auto aabb_min = frontier.header().aabb_min;
+  const auto aabb_max = frontier.header().aabb_max;
+  set_aabb(aabb_min, aabb_max);
+  // Chunked vertices have to be transformed by the model matrix.
+  model = glm::scale(glm::mat4{1.0f}, 1.0f / (0.5f * (aabb_max - aabb_min)));
+  model = glm::translate(model, -0.5f * (aabb_max + aabb_min));
+  // There is no attainment surface in out-of-core mode.
+  pending_surface = {};
+  surface_pending = true;
+  lines_changed = true;
+  frontier_changed = true;
+  ++data_version;
+}
+
+bool viewer::impl::stop_surface_job() {
+  // Only a running job reads the vertices. A completed one
+  // is kept such that its result is not discarded.
+  if (!surface_job.running()) return false;
+  surface_job.cancel();
+  return true;
+}
+
+void viewer::impl::begin_edit(bool surface_job_stopped) {
+  restart_surface_job = surface_job_stopped;
+}
+
+void viewer::impl::invalidate(size_t first, size_t last) {
+  last = min(last, chunked ? 0 : vertex_count());
+  if (first >= last) return;
+  if (!objectives.empty()) {
+    // Vertices borrowed together with the objectives cannot be written.
+    if (vertex_storage.empty()) {
+      transform_objectives(objectives, transform, vertex_storage);
+      vertices = vertex_storage;
+      account_vertices();
+    }
+    parallel_chunks(last - first, [&](size_t begin, size_t end, size_t) {
+      for (auto i = first + begin; i < first + end; ++i)
+        vertex_storage[i] = transform.to_render(objectives[i]);
+    });
+  }
+  vertex_changes.mark(first, last);
+  edited = true;
+}
+
+void viewer::impl::end_edit() {
+  if (edited) update_bounds();
+  if (edited || restart_surface_job) start_surface_job();
+  edited = false;
+  restart_surface_job = false;
+}
+
+void viewer::impl::update_bounds() {
+  bounds = objectives.empty() ? compute_objective_bounds(vertices)
+                              : compute_objective_bounds(objectives);
+  scaling = make_axis_scaling(bounds, transform, axis_scales);
+  set_aabb(transform.to_render(bounds.min), transform.to_render(bounds.max));
+  frontier_changed = true;
+  ++data_version;
+}
+
+void viewer::impl::set_aabb(const glm::vec3& aabb_min,
+                            const glm::vec3& aabb_max) {
+  aabb_vertices[0] = aabb_min;
+  aabb_vertices[1] = {aabb_min.x, aabb_min.y, aabb_max.z};
+  aabb_vertices[2] = {aabb_max.x, aabb_min.y, aabb_min.z};
+  aabb_vertices[3] = {aabb_max.x, aabb_min.y, aabb_max.z};
+  aabb_vertices[4] = {aabb_min.x, aabb_max.y, aabb_min.z};
+  aabb_vertices[5] = {aabb_min.x, aabb_max.y, aabb_max.z};
+  aabb_vertices[6] = {aabb_max.x, aabb_max.y, aabb_min.z};
+  aabb_vertices[7] = aabb_max;
+}
+
+void viewer::impl::start_surface_job() {
+  if (chunked || vertex_count() == 0) return;
+  restore_vertices();
+  // The handler runs at the end of the job. So slow work like writing
+  // the cache never blocks the render thread. The borrowed data stays
+  // valid because the job is cancelled before it changes.
+  surface_job.restart([points = vertices, reference = aabb_vertices[7],
+                       objectives = objectives, edges = edges,
+                       transform = transform, bounds = bounds,
+                       handler = surface_handler](
+                          const cancellation_token& token,
+                          const auto& publish) {
+    auto surface =
+        compute_attainment_surface(points, reference, token, publish);
+    token.check();
+    if (handler)
+      handler({objectives, points, edges, transform, bounds, surface.vertices,
+               surface.triangles, surface.axis_offsets,
+               surface.hypervolume});
+    return surface;
+  });
+}
+
+void viewer::impl::restore_vertices() {
+  if (vertices.size() == vertex_count()) return;
+  transform_objectives(objectives, transform, vertex_storage);
+  vertices = vertex_storage;
+  account_vertices();
+}
+
+void viewer::impl::release_vertices() {
+  // Borrowed vertices are owned by someone else. The uploads
+  // of modified vertices and the surface job still read them.
+  if (!options.gpu_resident || vertex_storage.empty() || objectives.empty() ||
+      frontier_changed || !vertex_changes.empty() || surface_job.running())
+    return;
+  vertex_storage = {};
+  vertices = {};
+  account_vertices();
+}
+
+void viewer::impl::account_vertices() {
+  vertex_memory.set(vertex_storage.capacity() * sizeof(glm::vec3));
+}
+
+span<const glm::vec3> viewer::impl::query_vertices(
+    large_vector<glm::vec3>& buffer) const {
+  if (vertices.size() == vertex_count()) return vertices;
+  transform_objectives(objectives, transform, buffer);
+  return buffer;
+}
+
+void viewer::impl::init() {
+  init_window();
+
+  // To initialize the viewport and matrices,
+  // window has to be resized at least once.
+  for (size_t i = 0; i < views.size(); ++i) {
+    auto& v = views[i];
+    glfwGetFramebufferSize(v.window, &v.screen_width, &v.screen_height);
+    post([this, i, width = v.screen_width, height = v.screen_height] {
+      resize(i, width, height);
+    });
+  }
+  // The context can only be current on one thread at a time.
+  glfwMakeContextCurrent(nullptr);
+  render_thread = thread{[this] { render_loop(); }};
+
+  is_initialized = true;
+}
+
+bool viewer::impl::process_events(double timeout) {
+  if (is_closed) return false;
+  if (!is_initialized) init();
+
+  // Handle user and OS events.
+  if (timeout > 0)
+    glfwWaitEventsTimeout(timeout);
+  else
+    glfwPollEvents();
+  for (size_t i = 0; i < views.size(); ++i) handle_input(i);
+  pair<size_t, string> title{};
+  while (window_titles.try_pop(title))
+    glfwSetWindowTitle(views[title.first].window, title.second.c_str());
+
+  // Closing one of the views closes the viewer.
+  const bool is_open =
+      none_of(begin(views), end(views), [](const view_state& v) {
+        return glfwWindowShouldClose(v.window);
+      });
+  if (is_open) return true;
+  is_closed = true;
+  stop_rendering = true;
+  render_thread.join();
+  // Background work has to stop before the thread pool is destroyed.
+  surface_job.cancel();
+  if (render_error) rethrow_exception(render_error);
+  return false;
+}
+
+void viewer::impl::render_image(const string& path) {
+  render_software({origin, radius, altitude, azimuth}, options.width,
+                  options.height)
+      .write_ppm(path);
+  // Without windows, the viewer is destroyed right after the image
+  // has been written. The surface handlers have to run before.
+  surface_job.wait();
+}
+
+software_rasterizer viewer::impl::render_software(const camera_state& camera,
+                                                  int width,
+                                                  int height) {
+  scoped_lock lock{data_mutex};
+  if (chunked)
+    throw runtime_error(
+        "Failed to render image because chunked frontiers "
+        "cannot be rendered in software.");
+  software_rasterizer image{width, height};
+  const auto projection =
+      glm::perspective(fov, float(width) / height, 0.1f, 10000.f);
+  const auto view = orbit_view(camera.origin, camera.radius, camera.altitude,
+                               camera.azimuth);
+  const auto mvp = projection * view * model;
+
+  // Draw the same lines and points as the OpenGL renderer.
+  const glm::vec3 black{0.0f, 0.0f, 0.0f};
+  image.clear({1.0f, 1.0f, 1.0f});
+  large_vector<glm::vec3> buffer{};
+  const auto points = query_vertices(buffer);
+  image.draw_lines(points, edges, scaling, mvp, black, 1);
+  image.draw_points(points, scaling, mvp, black, 3);
+  const vector<edge> box(begin(aabb_edges), end(aabb_edges));
+  const auto axes = span{box}.first(3);
+  image.draw_lines(aabb_vertices, axes, scaling, mvp, black, 3);
+  image.draw_lines(aabb_vertices, span{box}.subspan(3), scaling, mvp, black,
+                   1);
+  return image;
+}
+
+void viewer::impl::serve(const string& path) {
+  auto client = local_socket::accept(path);
+  camera_state camera{origin, radius, altitude, azimuth};
+  int width = options.width;
+  int height = options.height;
+  frame_encoder encoder{};
+  uint64_t frame_version = 0;
+  bool outdated = true;
+  vector<char> message{};
+  while (true) {
+    // Events are collected until the client is idle. Without any input,
+    // the server only wakes up to look for changes of the data.
+    if (client.readable(outdated ? 0 : 1000 / 60)) {
+      if (receive_message(client, message) != remote_message::event ||
+          message.size() != sizeof(remote_event))
+        throw runtime_error("Failed to read event from render client.");
+      remote_event event;
+      memcpy(&event, message.data(), sizeof(event));
+      const glm::vec2 move{event.x, event.y};
+      switch (event.type) {
+        case remote_event_type::resize:
+          // The client must not make the server render huge frames.
+          width = int(fminf(fmaxf(event.x, 1.0f), max_frame_extent));
+          height = int(fminf(fmaxf(event.y, 1.0f), max_frame_extent));
+          break;
+        case remote_event_type::orbit:
+          orbit_camera(camera, move);
+          break;
+        case remote_event_type::pan:
+          pan_camera(camera, move, height);
+          break;
+        case remote_event_type::zoom:
+          zoom_camera(camera, event.y);
+          break;
+        case remote_event_type::key:
+          if (event.key >= GLFW_KEY_1 && event.key <= GLFW_KEY_3) {
+            scoped_lock lock{data_mutex};
+            cycle_axis_scale(event.key - GLFW_KEY_1);
+          }
+          // Handlers run on the thread of the server.
+          for (const auto& [k, handler] : key_handlers)
+            if (k == event.key) handler();
+          break;
+        case remote_event_type::close:
+          return;
+      }
+      outdated = true;
+      continue;
+    }
+    {
+      scoped_lock lock{data_mutex};
+      if (data_version != frame_version) outdated = true;
+      frame_version = data_version;
+    }
+    if (!outdated) continue;
+    // Rasterization and encoding both run on the thread pool.
+    const auto image = render_software(camera, width, height);
+    const auto pixels = image.rows();
+    send_message(client, remote_message::frame,
+                 encoder.encode(pixels, width, height));
+    outdated = false;
+  }
+}
+
+void viewer::impl::cycle_axis_scale(int k) {
+  // Chunked frontiers are not normalized and only support linear axes.
+  if (chunked) return;
+  auto& scale = axis_scales[k];
+  scale = axis_scale((int(scale) + 1) % 3);
+  cout << "axis " << k << ": " << name(scale) << '\n';
+  scaling = make_axis_scaling(bounds, transform, axis_scales);
+  ++data_version;
+}
+
+void viewer::impl::init_window() {
+  // Create GLFW handler for error messages. Exceptions must not pass
+  // through GLFW. So the last error is kept for the failing call.
+  static string glfw_error{};
+  glfwSetErrorCallback([](int error, const char* description) {
+    glfw_error = "GLFW Error " + to_string(error) + ": " + description;
+  });
+
+  // Initialize GLFW.
+  if (!glfwInit())
+    throw window_error("Failed to initialize GLFW. " + glfw_error);
+
+  // Set required OpenGL context version for the window.
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  // Force GLFW to use the core profile of OpenGL.
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  // Set up anti-aliasing.
+  glfwWindowHint(GLFW_SAMPLES, 4);
+
+  views.resize(max<size_t>(options.view_count, 1));
+  for (size_t i = 0; i < views.size(); ++i) {
+    auto& v = views[i];
+    v.owner = this;
+    v.index = i;
+    // Further views look at the frontier from other sides.
+    v.camera = {origin, radius, altitude, azimuth + float(i * M_PI_2)};
+    v.frame_camera = v.camera;
+    v.old_camera = v.camera;
+    // Create the window to render in. Its context
+    // shares the objects of the context of the first view.
+    v.window = glfwCreateWindow(options.width, options.height,
+                                options.title.c_str(), nullptr,
+                                (i == 0) ? nullptr : views[0].window);
+    if (!v.window) {
+      // The viewer is not initialized. So nothing else cleans up.
+      for (auto& w : views)
+        if (w.window) glfwDestroyWindow(w.window);
+      views.clear();
+      glfwTerminate();
+      throw window_error("Failed to create window. " + glfw_error);
+    }
+    glfwSetWindowUserPointer(v.window, &v);
+    init_callbacks(v.window);
+  }
+}
+
+void viewer::impl::init_callbacks(GLFWwindow* window) {
+  // Views are found by the user pointer of their window.
+  static constexpr auto view_of = [](GLFWwindow* window) -> view_state& {
+    return *static_cast<view_state*>(glfwGetWindowUserPointer(window));
+  };
+
+  // Make window to be closed when pressing Escape
+  // by adding key event handler.
+  glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int scancode,
+                                int action, int mods) {
+    auto& self = *view_of(window).owner;
+    if (action != GLFW_PRESS) return;
+    if (key == GLFW_KEY_ESCAPE) glfwSetWindowShouldClose(window, GLFW_TRUE);
+    // Toggle the attainment surface.
+    if (key == GLFW_KEY_A)
+      self.post([&self] { self.show_surface = !self.show_surface; });
+    // Toggle the memory usage in the window titles.
+    if (key == GLFW_KEY_M)
+      self.post([&self] { self.show_memory = !self.show_memory; });
+    // Only uniforms are changed by the axis scales.
+    // Vertex buffers stay untouched.
+    if (key >= GLFW_KEY_1 && key <= GLFW_KEY_3) {
+      self.post([&self, k = key - GLFW_KEY_1] {
+        self.cycle_axis_scale(k);
+        self.upload_axis_scaling();
+      });
+    }
+    for (const auto& [k, handler] : self.key_handlers)
+      if (k == key) handler();
+  });
+
+  // Add zooming when scrolling.
+  glfwSetScrollCallback(window, [](GLFWwindow* window, double x, double y) {
+    zoom_camera(view_of(window).camera, float(y));
+  });
+
+  // Add resize handler.
+  glfwSetFramebufferSizeCallback(
+      window, [](GLFWwindow* window, int width, int height) {
+        auto& v = view_of(window);
+        v.screen_width = width;
+        v.screen_height = height;
+        v.owner->post([&v, width, height] {
+          v.owner->resize(v.index, width, height);
+        });
+      });
+}
+
+void viewer::impl::post(function<void()> command) {
+  // The render thread empties the queue every frame.
+  while (!render_commands.try_push(move(command)) && !render_stopped)
+    this_thread::yield();
+}
+
+void viewer::impl::handle_input(size_t index) {
+  auto& v = views[index];
+  v.old_mouse_pos = v.mouse_pos;
+  double xpos, ypos;
+  glfwGetCursorPos(v.window, &xpos, &ypos);
+  v.mouse_pos = glm::vec2{xpos, ypos};
+  const auto mouse_move = v.mouse_pos - v.old_mouse_pos;
+
+  const auto left = glfwGetMouseButton(v.window, GLFW_MOUSE_BUTTON_LEFT);
+  if (left == GLFW_PRESS) orbit_camera(v.camera, mouse_move);
+  const auto right = glfwGetMouseButton(v.window, GLFW_MOUSE_BUTTON_RIGHT);
+  if (right == GLFW_PRESS) pan_camera(v.camera, mouse_move, v.screen_height);
+
+  // Vertices are only picked while the camera is not dragged.
+  const bool hover = left != GLFW_PRESS && right != GLFW_PRESS &&
+                     mouse_move != glm::vec2{0.0f};
+  post([&v, state = v.camera, hover, position = v.mouse_pos] {
+    v.frame_camera = state;
+    if (!hover) return;
+    v.pick_position = position;
+    v.pick_requested = true;
+  });
+}
+
+void viewer::impl::render_loop() {
+  try {
+    // Initialize the OpenGL contexts of all windows by using glbinding.
+    for (size_t i = 0; i < views.size(); ++i) {
+      glfwMakeContextCurrent(views[i].window);
+      glbinding::initialize(
+          reinterpret_cast<glbinding::ContextHandle>(views[i].window),
+          glfwGetProcAddress);
+    }
+    make_current(0);
+    {
+      scoped_lock lock{data_mutex};
+      // The shader has to be initialized before
+      // the initialization of the vertex data
+      // due to identifier location variables
+      // that have to be set after creating the shader program.
+      init_shader();
+      init_vertex_data();
+      for (size_t i = 0; i < views.size(); ++i) init_view(i);
+    }
+
+    function<void()> command{};
+    while (!stop_rendering) {
+      // Shared objects are changed in the context of the first view.
+      make_current(0);
+      {
+        // Borrowed data is only read while it is not edited.
+        scoped_lock lock{data_mutex};
+        while (render_commands.try_pop(command)) command();
+        update();
+        for (size_t i = 0; i < views.size(); ++i) update_view(i);
+      }
+      // Other contexts only see the changes after a flush.
+      glFlush();
+      for (size_t i = 0; i < views.size(); ++i) {
+        make_current(i);
+        render(i);
+        // Swap buffers to display the
+        // new content of the frame buffer.
+        glfwSwapBuffers(views[i].window);
+      }
+    }
+  } catch (...) {
+    render_error = current_exception();
+    glfwSetWindowShouldClose(views[0].window, GLFW_TRUE);
+    glfwPostEmptyEvent();
+  }
+  free_vertex_data();
+  glfwMakeContextCurrent(nullptr);
+  render_stopped = true;
+}
+
+void viewer::impl::make_current(size_t index) {
+  glfwMakeContextCurrent(views[index].window);
+  glbinding::useContext(
+      reinterpret_cast<glbinding::ContextHandle>(views[index].window));
+}
+
+void viewer::impl::init_view(size_t index) {
+  auto& v = views[index];
+  make_current(index);
+  // Only the first view waits for the vertical retrace.
+  // Otherwise, every further view would reduce the frame rate.
+  if (index > 0) glfwSwapInterval(0);
+
+  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+  glEnable(GL_DEPTH_TEST);
+  // The attainment surface is drawn transparently.
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  // Use a vertex array to be able to reference the vertex buffer and
+  // the vertex attribute arrays of the AABB with one single variable.
+  glGenVertexArrays(1, &v.aabb_vertex_array);
+  glBindVertexArray(v.aabb_vertex_array);
+  glBindBuffer(GL_ARRAY_BUFFER, aabb_vertex_buffer);
+  // Set the data layout of the position and colors
+  // with vertex attribute pointers.
+  glEnableVertexAttribArray(vpos_location);
+  glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE,
+                        sizeof(decltype(aabb_vertices)::value_type), (void*)0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, aabb_element_buffer);
+
+  // Do the same for the attainment surface.
+  glGenVertexArrays(1, &v.surface_vertex_array);
+  glBindVertexArray(v.surface_vertex_array);
+  glBindBuffer(GL_ARRAY_BUFFER, surface_vertex_buffer);
+  glEnableVertexAttribArray(vpos_location);
+  glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE,
+                        sizeof(decltype(surface.vertices)::value_type),
+                        (void*)0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, surface_element_buffer);
+
+  // Lines are uploaded with the first frame that shows a frontier.
+  lines.create_vertex_arrays(index, vpos_location);
+}
+
+void viewer::impl::upload_frontier() {
+  if (lines_changed) {
+    // In out-of-core mode, the vertex data is streamed into a buffer pool.
+    if (streamer) {
+      streamer->free();
+      streamer.reset();
+    }
+    if (chunked) {
+      streamer =
+          make_unique<chunk_streamer>(*chunked, options.chunk_pool_slots);
+      streamer->init(vpos_location);
+    }
+    upload_lines();
+  }
+  upload_axis_scaling();
+  upload_aabb();
+  for (size_t i = 0; i < views.size(); ++i) {
+    views[i].hovered = no_vertex;
+    window_titles.try_push({i, options.title});
+  }
+  frontier_changed = false;
+  lines_changed = false;
+}
+
+void viewer::impl::upload_lines() {
+  // Vertex arrays of further views would reference deleted buffers.
+  for (size_t i = 1; i < views.size(); ++i) {
+    make_current(i);
+    lines.delete_vertex_arrays(i);
+  }
+  make_current(0);
+  lines.free();
+  // Upload vertices and edges. Large frontiers are split
+  // into multiple buffers and draw calls inside the driver limits.
+  // The edges are reordered by block in a temporary copy.
+  vector<edge> reordered(begin(edges), end(edges));
+  memory_account reordered_memory{memory_pool::indices};
+  reordered_memory.set(reordered.size() * sizeof(edge));
+  lines.upload(vertices, reordered, vpos_location, query_buffer_limits());
+  glFlush();
+  for (size_t i = 1; i < views.size(); ++i) {
+    make_current(i);
+    lines.create_vertex_arrays(i, vpos_location);
+  }
+  make_current(0);
+}
+
+void viewer::impl::free_vertex_data() {
+  for (size_t i = 0; i < views.size(); ++i) {
+    make_current(i);
+    glDeleteVertexArrays(1, &views[i].aabb_vertex_array);
+    glDeleteVertexArrays(1, &views[i].surface_vertex_array);
+    if (i > 0) lines.delete_vertex_arrays(i);
+  }
+  make_current(0);
+  if (streamer) {
+    streamer->free();
+    streamer.reset();
+  }
+  glDeleteBuffers(1, &surface_element_buffer);
+  glDeleteBuffers(1, &surface_vertex_buffer);
+  gpu_surface_memory.set(0);
+  glDeleteBuffers(1, &aabb_element_buffer);
+  glDeleteBuffers(1, &aabb_vertex_buffer);
+  lines.free();
+  // Delete shader program.
+  glDeleteProgram(program);
+}
+
+void viewer::impl::init_shader() {
+  // Compile and create the vertex shader.
+  auto vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vertex_shader, 1, &vertex_shader_text, nullptr);
+  glCompileShader(vertex_shader);
+  {
+    // Check for errors.
+    GLint success;
+    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+      char info_log[512];
+      glGetShaderInfoLog(vertex_shader, 512, nullptr, info_log);
+      throw runtime_error(
+          string("OpenGL Error: Failed to compile vertex shader!: ") +
+          info_log);
+    }
+  }
+
+  // Compile and create the fragment shader.
+  auto fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fragment_shader, 1, &fragment_shader_text, nullptr);
+  glCompileShader(fragment_shader);
+  {
+    // Check for errors.
+    GLint success;
+    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+      char info_log[512];
+      glGetShaderInfoLog(fragment_shader, 512, nullptr, info_log);
+      throw runtime_error(
+          string("OpenGL Error: Failed to compile fragment shader!: ") +
+          info_log);
+    }
+  }
+
+  // Link vertex shader and fragment shader to shader program.
+  program = glCreateProgram();
+  glAttachShader(program, vertex_shader);
+  glAttachShader(program, fragment_shader);
+  glLinkProgram(program);
+  {
+    // Check for errors.
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+      char info_log[512];
+      glGetProgramInfoLog(program, 512, nullptr, info_log);
+      throw runtime_error(
+          string("OpenGL Error: Failed to link shader program!: ") + info_log);
+    }
+  }
+
+  // Delete unused shaders.
+  glDeleteShader(vertex_shader);
+  glDeleteShader(fragment_shader);
+
+  // Get identifier locations in the shader program
+  // to change their values from the outside.
+  mvp_location = glGetUniformLocation(program, "MVP");
+  vpos_location = glGetAttribLocation(program, "vPos");
+  color_location = glGetUniformLocation(program, "color");
+  axis_scale_location = glGetUniformLocation(program, "axis_scale");
+  axis_offset_location = glGetUniformLocation(program, "axis_offset");
+  axis_factor_location = glGetUniformLocation(program, "axis_factor");
+  axis_center_location = glGetUniformLocation(program, "axis_center");
+  axis_radius_location = glGetUniformLocation(program, "axis_radius");
+  axis_threshold_location = glGetUniformLocation(program, "axis_threshold");
+  axis_min_location = glGetUniformLocation(program, "axis_min");
+  axis_max_location = glGetUniformLocation(program, "axis_max");
+  upload_axis_scaling();
+}
+
+void viewer::impl::init_vertex_data() {
+  // Vertex arrays are created per view.
+  // Generate and bind the buffer which shall contain the AABB data.
+  glGenBuffers(1, &aabb_vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, aabb_vertex_buffer);
+  // The data is not changing rapidly. Therefore we use GL_STATIC_DRAW.
+  glBufferData(
+      GL_ARRAY_BUFFER,
+      aabb_vertices.size() * sizeof(decltype(aabb_vertices)::value_type),
+      aabb_vertices.data(), GL_STATIC_DRAW);
+
+  // Generate buffer for the edges. The element buffer binding
+  // belongs to the bound vertex array. So it is filled by using
+  // the array buffer target that is part of the context.
+  glGenBuffers(1, &aabb_element_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, aabb_element_buffer);
+  glBufferData(GL_ARRAY_BUFFER,
+               aabb_edges.size() * sizeof(decltype(aabb_edges)::value_type),
+               aabb_edges.data(), GL_STATIC_DRAW);
+
+  // Do the same for the attainment surface.
+  glGenBuffers(1, &surface_vertex_buffer);
+  glGenBuffers(1, &surface_element_buffer);
+  upload_surface();
+}
+
+void viewer::impl::upload_axis_scaling() {
+  glUseProgram(program);
+  glUniform3i(axis_scale_location, int(scaling.scales[0]),
+              int(scaling.scales[1]), int(scaling.scales[2]));
+  glUniform3fv(axis_offset_location, 1, glm::value_ptr(scaling.offset));
+  glUniform3fv(axis_factor_location, 1, glm::value_ptr(scaling.factor));
+  glUniform3fv(axis_center_location, 1, glm::value_ptr(scaling.center));
+  glUniform3fv(axis_radius_location, 1, glm::value_ptr(scaling.radius));
+  glUniform3fv(axis_threshold_location, 1, glm::value_ptr(scaling.threshold));
+  glUniform3fv(axis_min_location, 1, glm::value_ptr(scaling.scaled_min));
+  glUniform3fv(axis_max_location, 1, glm::value_ptr(scaling.scaled_max));
+}
+
+void viewer::impl::upload_aabb() {
+  glBindBuffer(GL_ARRAY_BUFFER, aabb_vertex_buffer);
+  glBufferSubData(
+      GL_ARRAY_BUFFER, 0,
+      aabb_vertices.size() * sizeof(decltype(aabb_vertices)::value_type),
+      aabb_vertices.data());
+}
+
+void viewer::impl::upload_surface() {
+  // The element buffer is bound to the vertex arrays of all views.
+  // So both buffers are filled by using the array buffer target.
+  glBindBuffer(GL_ARRAY_BUFFER, surface_vertex_buffer);
+  const auto vertex_bytes =
+      surface.vertices.size() * sizeof(decltype(surface.vertices)::value_type);
+  glBufferData(GL_ARRAY_BUFFER, vertex_bytes, surface.vertices.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, surface_element_buffer);
+  const auto triangle_bytes =
+      surface.triangles.size() *
+      sizeof(decltype(surface.triangles)::value_type);
+  glBufferData(GL_ARRAY_BUFFER, triangle_bytes, surface.triangles.data(),
+               GL_STATIC_DRAW);
+  gpu_surface_memory.set(vertex_bytes + triangle_bytes);
+  surface_memory.set(
+      surface.vertices.capacity() *
+          sizeof(decltype(surface.vertices)::value_type) +
+      surface.triangles.capacity() *
+          sizeof(decltype(surface.triangles)::value_type));
+}
+
+void viewer::impl::resize(size_t index, int width, int height) {
+  // Update size parameters and compute aspect ratio.
+  // The viewport is set before rendering in the context of the view.
+  auto& v = views[index];
+  v.frame_width = width;
+  v.frame_height = height;
+  const auto aspect_ratio = float(v.frame_width) / v.frame_height;
+  // Use a perspective projection with correct aspect ratio.
+  v.projection = glm::perspective(fov, aspect_ratio, 0.1f, 10000.f);
+}
+
+void viewer::impl::update() {
+  if (frontier_changed) upload_frontier();
+  // Upload a bounded part of the modified vertices per frame.
+  vertex_changes.flush(vertex_upload_budget, [this](size_t first, size_t last) {
+    lines.update(vertices, first, last);
+  });
+  if (surface_pending) {
+    surface = move(pending_surface);
+    surface_pending = false;
+    upload_surface();
+  }
+  // Show the faces of the attainment surface as soon as they are published.
+  try {
+    if (surface_job.poll(surface) != job_status::none) upload_surface();
+  } catch (exception& e) {
+    cerr << e.what() << '\n';
+  }
+  release_vertices();
+}
+
+void viewer::impl::update_view(size_t index) {
+  auto& v = views[index];
+  const auto& frame_camera = v.frame_camera;
+  v.view = orbit_view(frame_camera.origin, frame_camera.radius,
+                      frame_camera.altitude, frame_camera.azimuth);
+
+  // Report the objective values of the hovered vertex in the window title.
+  // They are taken from the double-precision data and not from the GPU.
+  // Picking is done in front of all background work.
+  auto title_changed = false;
+  if (v.pick_requested && vertex_count() > 0) {
+    v.pick_requested = false;
+    const priority_scope scope{task_priority::interactive};
+    const auto mvp = v.projection * v.view * model;
+    const glm::vec2 screen(v.frame_width, v.frame_height);
+    const auto picked =
+        vertices.empty()
+            ? pick_vertex(objectives, transform, scaling, mvp, v.pick_position,
+                          screen, 10.0f)
+            : pick_vertex(vertices, scaling, mvp, v.pick_position, screen,
+                          10.0f);
+    if (picked != v.hovered) {
+      v.hovered = picked;
+      stringstream text{};
+      if (v.hovered != no_vertex) {
+        const auto x = objectives.empty()
+                           ? transform.to_objective(vertices[v.hovered])
+                           : objectives[v.hovered];
+        text << setprecision(17) << " | " << v.hovered << ": (" << x.x << ", "
+             << x.y << ", " << x.z << ")";
+      }
+      v.hover_text = text.str();
+      title_changed = true;
+    }
+  }
+  // The memory usage is refreshed twice a second while it is shown.
+  const auto time = glfwGetTime();
+  if (title_changed || v.memory_shown != show_memory ||
+      (show_memory && time - v.memory_time > 0.5)) {
+    v.memory_shown = show_memory;
+    v.memory_time = time;
+    auto title = options.title + v.hover_text;
+    if (show_memory) title += " | " + memory_summary();
+    // The title is dropped if the event thread has fallen far behind.
+    window_titles.try_push({index, move(title)});
+  }
+
+  v.mvp = v.projection * v.view * model;
+
+  // Extrapolate the camera motion linearly to know
+  // which chunks will be visible in the near future.
+  // Chunks are only streamed for the first view.
+  if (streamer && index == 0) {
+    constexpr float bound = M_PI_2 - 1e-5f;
+    const auto& c = v.frame_camera;
+    const auto& o = v.old_camera;
+    const auto predicted_view = orbit_view(
+        c.origin + prefetch_frames * (c.origin - o.origin),
+        c.radius * pow(c.radius / o.radius, prefetch_frames),
+        clamp(c.altitude + prefetch_frames * (c.altitude - o.altitude),
+              -bound, bound),
+        c.azimuth + prefetch_frames * (c.azimuth - o.azimuth));
+    streamer->update(v.mvp, v.projection * predicted_view * model);
+  }
+  v.old_camera = v.frame_camera;
+}
+
+void viewer::impl::render(size_t index) {
+  auto& v = views[index];
+  glViewport(0, 0, v.frame_width, v.frame_height);
+  // Clear the screen.
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  // Use the created shader with the matrices of the view.
+  glUseProgram(program);
+  glUniformMatrix4fv(mvp_location, 1, GL_FALSE, glm::value_ptr(v.mvp));
+  glUniform4f(color_location, 0.0f, 0.0f, 0.0f, 1.0f);
+  if (streamer) {
+    if (index == 0) streamer->render();
+  } else {
+    glLineWidth(1.5f);
+    lines.render(index);
+    // Tables and arrays have no edges. So vertices are always shown.
+    glPointSize(3.0f);
+    lines.render_points(index);
+    glPointSize(1.0f);
+  }
+  glBindVertexArray(v.aabb_vertex_array);
+  glLineWidth(3.0f);
+  glDrawElements(GL_LINES, 3 * 2, GL_UNSIGNED_INT, 0);
+  glLineWidth(1.0f);
+  glDrawElements(GL_LINES, 9 * 2, GL_UNSIGNED_INT,
+                 (void*)(3 * sizeof(decltype(aabb_edges)::value_type)));
+
+  // Draw the attainment surface after all opaque geometry.
+  // Every normal axis gets its own shade to make the staircase visible.
+  if (show_surface) {
+    constexpr array<float, 3> shades{0.55f, 0.7f, 0.85f};
+    glEnable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(v.surface_vertex_array);
+    for (int k = 0; k < 3; ++k) {
+      const auto first = surface.axis_offsets[k];
+      const auto count = surface.axis_offsets[k + 1] - first;
+      glUniform4f(color_location, 0.2f * shades[k], 0.4f * shades[k],
+                  shades[k], 0.5f);
+      glDrawElements(
+          GL_TRIANGLES, 3 * count, GL_UNSIGNED_INT,
+          (void*)(first * sizeof(decltype(surface.triangles)::value_type)));
+    }
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+  }
+}
+
+}  // namespace vipo
@@ -0,0 +1,147 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+//
+#include <glm/glm.hpp>
+//
+#include "attainment_surface.hpp"
+#include "frontier_cache.hpp"
+#include "frontier_file.hpp"
+#include "objective_space.hpp"
+#include "out_of_core.hpp"
+
+namespace vipo {
+
+struct viewer_options {
+  std::string title = "VIPO: Pareto Frontier Viewer";
+  int width = 500;
+  int height = 500;
+  // Number of windows showing the frontier from their own camera.
+  size_t view_count = 1;
+  // Number of chunks kept on the GPU in out-of-core mode.
+  size_t chunk_pool_slots = 256;
+  // Free the float vertices mapped from objectives after their upload.
+  // Picking and software rendering then map the objectives on the fly.
+  // Borrowed float vertices are never copied and stay as they are.
+  bool gpu_resident = false;
+};
+
+// Frontier data borrowed by the viewer. The edges are only copied
+// while they are reordered for the upload. Objectives are mapped onto
+// float vertices owned by the viewer. Float vertices without objectives
+// are rendered as they are. If both are given, the vertices have to be
+// the objectives mapped by the given transform, e.g. from a cache entry.
+struct viewer_data {
+  std::span<const glm::dvec3> objectives{};
+  std::span<const glm::vec3> vertices{};
+  std::span<const edge> edges{};
+  objective_transform transform{};
+  // Precomputed attainment surface. If missing,
+  // it is computed in the background.
+  const attainment_surface* surface = nullptr;
+};
+
+// Thrown by 'poll' and 'run' if GLFW cannot be initialized or the windows
+// and their OpenGL contexts cannot be created, e.g. without a display.
+// Rendering in software by 'render_image' still works in this case.
+struct window_error : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+// Interactive viewer of a Pareto frontier that can be embedded
+// into other applications like optimizers to show their archive
+// without any serialization. Windows are created by the first call
+// to 'poll' or 'run' whose thread has to handle all window events.
+// Frames are rendered on a separate thread. GLFW is global.
+// So there may only be one viewer at a time.
+//
+// The viewer reads borrowed data from its own threads. So it must only
+// be modified inside of an 'edit' scope which tells the viewer
+// which parts have changed. Borrowed data has to stay valid
+// until other data is shown or the viewer is destroyed.
+class viewer {
+ public:
+  class edit_scope;
+
+  explicit viewer(viewer_options options = {});
+  ~viewer();
+  viewer(const viewer&) = delete;
+  viewer& operator=(const viewer&) = delete;
+
+  // Show the given frontier instead of the current one. If the number
+  // of vertices and the edges are the same, only changed vertices
+  // are uploaded. The transform of the objectives is kept in this case
+  // such that unmodified objectives are mapped to the same vertices.
+  // The old data is read while comparing and has to be valid until then.
+  // Throws 'std::runtime_error' if an edge references a non-existing
+  // vertex. Edits of the edges have to keep them valid.
+  void show(const viewer_data& data);
+  // Show a chunked frontier in out-of-core mode.
+  // Its chunks are only streamed into the first view.
+  void show(const chunked_frontier& frontier);
+
+  // Get exclusive access to the borrowed data to modify it in place.
+  // The viewer does not read the data until the scope is destroyed.
+  edit_scope edit();
+
+  // Call the handler on the event thread whenever the GLFW key is pressed.
+  // Handlers have to be added before the windows are created.
+  void on_key(int key, std::function<void()> handler);
+  // Call the handler whenever an attainment surface has been computed.
+  // It runs on the thread pool at the end of the background job in every
+  // mode. So it may do slow work without stalling the rendering.
+  // The entry contains everything that is needed to store the derived
+  // data of the frontier in a cache file. It is only valid during the call.
+  void on_surface(std::function<void(const frontier_cache_entry&)> handler);
+
+  // Create the windows if needed and handle their pending events.
+  // Returns false if a window has been closed. Then, rendering is stopped
+  // and errors of the render thread are rethrown. Throws 'window_error'
+  // if the windows cannot be created.
+  bool poll();
+  // Handle window events until a window is closed.
+  void run();
+
+  // Render the frontier from the initial camera into a PPM file
+  // in software. Works without windows and OpenGL. Waits for
+  // the attainment surface afterwards such that its handler is called.
+  void render_image(const std::string& path);
+  // Run headless as render server instead of opening windows.
+  // Waits for one client at the given local socket, renders frames
+  // in software, and sends them compressed whenever the camera or
+  // the data has changed. Returns when the client has been closed.
+  // Key handlers are called on the calling thread.
+  void serve(const std::string& path);
+
+ private:
+  struct impl;
+  std::unique_ptr<impl> self_;
+};
+
+// Changes of borrowed data have to be announced by 'invalidate'.
+// They are uploaded when the scope is destroyed.
+class viewer::edit_scope {
+ public:
+  ~edit_scope();
+  edit_scope(const edit_scope&) = delete;
+  edit_scope& operator=(const edit_scope&) = delete;
+
+  // Mark the objectives or vertices in [first, last) as modified.
+  // The number of them must not change. Use 'show' instead.
+  void invalidate(size_t first, size_t last);
+
+ private:
+  friend class viewer;
+  explicit edit_scope(impl& owner);
+
+  impl& owner_;
+  std::unique_lock<std::mutex> lock_;
+};
+
+}  // namespace vipo